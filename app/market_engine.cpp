@@ -1,29 +1,454 @@
 /*
 * Script that lets users place orders and see the order book and trades executed.
+*
+* Usage:
+*   ./market_engine                          // Unbounded prices (OrderBook)
+*   ./market_engine --ladder <min> <max>     // Prices bounded to [min, max] (PriceLadderBook)
+*   ./market_engine --journal <file> [--snapshot <file>]
+*                                            // Rebuild the book from the files at start, journal every
+*                                            // accepted command, and snapshot the book now and then
+*   ./market_engine --levels <n>             // Show at most n levels per side of the book
+*   ./market_engine --encode <file>          // Write the orders typed on stdin to a binary order file
+*   ./market_engine --replay <file> [--quiet] [--feed <file>] [--ladder <min> <max>]
+*                                            // Replay a binary order file, print the trades and the
+*                                            // orders/sec and trades/sec (--quiet: no trades, --feed:
+*                                            // also write the L2 market-data feed to a file)
+*   ./market_engine --ingest <file> [--quiet] [--feed <file>] [--ladder <min> <max>]
+*                                            // Same for a text file of orders as typed below, parsed
+*                                            // in bulk by tokenize_orders
+*   ./market_engine --pipeline [--futex] [--quiet] [--ladder <min> <max>]
+*                                            // Read orders typed on stdin on one thread, match them on
+*                                            // a second and print the trades on a third (--futex: idle
+*                                            // threads sleep instead of spinning)
+*
+* Besides orders, the following commands are accepted. Accepted orders are numbered 1, 2, 3, ...
+*   C <Id>             Cancel a resting order
+*   M <Id> <Quantity>  Change the quantity of a resting order
 */
 
+#include "book_snapshot.hpp"
+#include "event_queue.hpp"
+#include "event_sink.hpp"
+#include "journal.hpp"
+#include "market_data.hpp"
 #include "order_book.hpp"
+#include "order_parser.hpp"
+#include "order_record.hpp"
+#include "order_tokenizer.hpp"
+#include "price_ladder_book.hpp"
+#include "spsc_queue.hpp"
+#include "tsc_clock.hpp"
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
 #include <iostream>
 #include <string>
+#include <string_view>
+#include <thread>
 using namespace std;
 
-int main() {
+// Bytes of trade output collected before a write to stdout during a replay.
+const size_t REPLAY_OUTPUT_BUFFER = 1 << 16;
+
+// Journaled commands between two snapshots of the interactive book.
+const uint64_t SNAPSHOT_INTERVAL = 100000;
+
+// Slots in each of the queues between the threads of --pipeline.
+const size_t PIPELINE_QUEUE_SIZE = 1 << 16;
+
+class ReplaySink : public EventSink {
+    /*
+    * Counts trades and rejections during a replay, and prints the trades as "<quantity>@<price>"
+    * lines in large batches instead of once per order.
+    */
+
+private:
+    TickSize tick_size;
+    bool     print_trades;
+    string   buffer;
+
+public:
+    uint64_t trades   = 0;
+    uint64_t rejected = 0;
+
+    ReplaySink(TickSize tick_size, bool print_trades) : tick_size(tick_size), print_trades(print_trades) {
+        buffer.reserve(REPLAY_OUTPUT_BUFFER + 64);
+    }
+
+    ~ReplaySink() override { write_out(); }
+
+    void on_trade(const TradeEvent& trade) override {
+        trades++;
+        if (!print_trades) return;
+        char digits[24];
+        auto end = to_chars(digits, digits + sizeof(digits), trade.quantity).ptr;
+        buffer.append(digits, end);
+        buffer += '@';
+        buffer += format_price(trade.price, tick_size);
+        buffer += '\n';
+        if (buffer.size() >= REPLAY_OUTPUT_BUFFER) write_out();
+    }
+
+    void on_reject(const RejectEvent&) override { rejected++; }
+
+    void write_out() {
+        fwrite(buffer.data(), 1, buffer.size(), stdout);
+        buffer.clear();
+    }
+};
+
+// Parse a whole token as a positive integer.
+template <class Integer>
+bool parse_positive(string_view text, Integer& value) {
+    auto [end, error] = from_chars(text.data(), text.data() + text.size(), value);
+    return error == errc() && end == text.data() + text.size() && value > 0;
+}
+
+// Where the interactive book is kept across restarts: --journal, and optionally --snapshot.
+struct BookFiles {
+    string   journal_path;
+    string   snapshot_path;
+    Journal  journal;
+    uint64_t snapshot_sequence = 0; // Journal sequence number of the last snapshot.
+
+    // Journal an accepted command, durably before the next prompt, and snapshot the book every SNAPSHOT_INTERVAL commands.
+    template <class Book>
+    void record(const Book& order_book, const OrderRequest& request) {
+        journal.append(request);
+        if (!journal.commit()) cerr << "ERROR: Cannot write " << journal_path << endl;
+        if (!snapshot_path.empty() && journal.last_sequence() - snapshot_sequence >= SNAPSHOT_INTERVAL) snapshot(order_book);
+    }
+
+    template <class Book>
+    void snapshot(const Book& order_book) {
+        if (!save_snapshot(order_book, snapshot_path, journal.last_sequence())) cerr << "ERROR: Cannot write " << snapshot_path << endl;
+        else snapshot_sequence = journal.last_sequence();
+    }
+};
+
+// Rebuild the book from its snapshot (if any) and the journal after it, without printing, then open the
+// journal for appending. Returns false if the journal cannot be opened.
+template <class Book>
+bool restore(Book& order_book, BookFiles& files) {
+    NullSink silent;
+    order_book.set_sink(&silent);
+    auto start = chrono::steady_clock::now();
+
+    uint64_t sequence = 0;
+    bool from_snapshot = !files.snapshot_path.empty() && load_snapshot(order_book, files.snapshot_path, sequence);
+    MappedJournal records;
+    size_t replayed = records.open(files.journal_path) ? replay_journal(order_book, records.records(), sequence) : 0;
+    files.snapshot_sequence = sequence;
+    order_book.set_sink(nullptr);
+
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    if (from_snapshot || replayed > 0)
+        cerr << "Restored " << (from_snapshot ? "snapshot and " : "") << replayed << " journaled commands in "
+             << seconds << " s" << endl;
+    return files.journal.open(files.journal_path);
+}
+
+// Handle a cancel (C <Id>) or modify (M <Id> <Quantity>) command. Returns false once input runs out.
+template <class Book>
+bool amend_order(Book& order_book, char command, BookFiles* files, size_t levels) {
+    string id_str, quantity_str;
+    if (!(cin >> id_str) || (command == 'M' && !(cin >> quantity_str))) return false;
+
+    OrderId id;
+    Quantity quantity = 0;
+    bool success = parse_positive(id_str, id) && (command == 'C' || parse_positive(quantity_str, quantity));
+    if (success) {
+        ValidationResult result;
+        if (command == 'C') result = order_book.cancel_order(id) ? ValidationResult::VALID : ValidationResult::UNKNOWN_ORDER_ID;
+        else                result = order_book.modify_order(id, quantity);
+        success = result == ValidationResult::VALID;
+        // A modify over a risk limit is reported by the book's sink, like a rejected add.
+        if (result == ValidationResult::UNKNOWN_ORDER_ID) cout << "ERROR: No resting order with id " << id << endl;
+    } else {
+        cout << "ERROR: Order id and quantity should be positive integers" << endl;
+    }
+
+    if (!success) {
+        cout << "Ignoring input. Please re-enter:" << endl;
+        return true;
+    }
+    if (files != nullptr) files->record(order_book, command == 'C' ? OrderRequest::cancel(id) : OrderRequest::modify(id, quantity));
+    order_book.print_order_book(levels);
+    cout << endl;
+    return true;
+}
+
+template <class Book>
+void run(Book& order_book, BookFiles* files, size_t levels) {
     cout << "Enter trades in format <Side> <Quantity> <Price>" << endl;
     char side;
     string quantity, price;
-    // We could have the actual UTC seconds since epoch value here. 
-    // For now, using just a counter for simplicity.
+    // Wall-clock nanoseconds since the epoch, kept with each order as metadata; priority is by the book's
+    // sequence numbers.
+    TscClock clock;
     long timestamp = 0;
 
-    OrderBook order_book;
-    while (cin >> side >> quantity >> price) {
-        bool success = order_book.add_order(side, quantity, price, ++timestamp);
-        if (!success) {
+    while (cin >> side) {
+        if (side == 'C' || side == 'M') {
+            if (!amend_order(order_book, side, files, levels)) break;
+            continue;
+        }
+        if (!(cin >> quantity >> price)) break;
+
+        timestamp  = clock.now();
+        OrderId id = order_book.add_order(side, quantity, price, timestamp);
+        if (id == INVALID_ORDER_ID) {
             cout << "Ignoring input. Please re-enter:" << endl;
             continue;
         }
-        order_book.execute_and_print_trades();
-        order_book.print_order_book();
+        if (files != nullptr) {
+            // The book accepted the text, so it parses; journal it in parsed form with the id it got.
+            ParsedOrder order;
+            parse_order(side, quantity, price, order_book.tick(), order);
+            files->record(order_book, OrderRequest::add(order.side, order.quantity, order.price, timestamp, id));
+        }
+        order_book.print_order_book(levels);
         cout << endl;
     }
-}
\ No newline at end of file
+    if (files != nullptr && !files->snapshot_path.empty()) files->snapshot(order_book);
+}
+
+// Feed every record of a binary order file into the book, then report the throughput.
+template <class Book>
+void replay(Book& order_book, ReplaySink& sink, const MappedOrderFile& file) {
+    auto records = file.records();
+    auto start   = chrono::steady_clock::now();
+    for (const OrderRecord& record : records)
+        order_book.add_order(record.side, record.quantity, record.price, record.timestamp, record.id);
+    double seconds = max(chrono::duration<double>(chrono::steady_clock::now() - start).count(), 1e-9);
+    sink.write_out();
+    fflush(stdout);
+
+    cerr << records.size() << " orders (" << sink.rejected << " rejected), " << sink.trades << " trades in "
+         << seconds << " s: " << static_cast<uint64_t>(records.size() / seconds) << " orders/sec, "
+         << static_cast<uint64_t>(sink.trades / seconds) << " trades/sec" << endl;
+}
+
+// Parse a whole text file of orders into columns, feed them into the book as one batch, then report the throughput.
+template <class Book>
+void ingest(Book& order_book, ReplaySink& sink, const MappedFile& file) {
+    TscClock clock;
+    auto start = chrono::steady_clock::now();
+    OrderColumns orders;
+    tokenize_orders(file.bytes(), DEFAULT_TICK_SIZE, orders);
+    auto parsed = chrono::steady_clock::now();
+    order_book.add_orders(orders, clock.now());
+    auto matched = chrono::steady_clock::now();
+    sink.write_out();
+    fflush(stdout);
+
+    double parse_seconds = max(chrono::duration<double>(parsed - start).count(), 1e-9);
+    double match_seconds = max(chrono::duration<double>(matched - parsed).count(), 1e-9);
+    cerr << orders.size() << " orders (" << sink.rejected << " rejected, " << orders.malformed_lines
+         << " malformed lines) parsed in " << parse_seconds << " s: "
+         << static_cast<uint64_t>(file.bytes().size() / parse_seconds / 1e6) << " MB/sec, "
+         << static_cast<uint64_t>(orders.size() / parse_seconds) << " orders/sec" << endl;
+    cerr << sink.trades << " trades in " << match_seconds << " s: "
+         << static_cast<uint64_t>(orders.size() / match_seconds) << " orders/sec, "
+         << static_cast<uint64_t>(sink.trades / match_seconds) << " trades/sec" << endl;
+}
+
+// A line parsed by the gateway thread of --pipeline, or the end of the input.
+struct GatewayMessage {
+    OrderRequest     request;
+    ValidationResult result;   // Why the line was refused, or VALID.
+    bool             end;
+};
+
+// Read orders from stdin on this thread, match them on a second one and print the trades on a third,
+// then report the throughput. The matcher only ever waits on the queues, never on I/O.
+template <class WaitPolicy>
+void pipeline(bool ladder, Price low, Price high, ReplaySink& sink) {
+    SpscQueue<GatewayMessage, WaitPolicy> requests(PIPELINE_QUEUE_SIZE);
+    SpscQueue<BookEvent, WaitPolicy>      events(PIPELINE_QUEUE_SIZE);
+    EventQueueSink<WaitPolicy>            queue_sink(events);
+
+    thread matcher([&] {
+        auto match = [&](auto& order_book) {
+            GatewayMessage message;
+            for (requests.pop(message); !message.end; requests.pop(message)) {
+                if (message.result == ValidationResult::VALID) {
+                    order_book.submit(message.request);
+                } else {
+                    queue_sink.on_reject(RejectEvent{message.result});
+                    queue_sink.flush();
+                }
+            }
+            queue_sink.close();
+        };
+        if (ladder) {
+            PriceLadderBook order_book(low, high, DEFAULT_TICK_SIZE, &queue_sink);
+            match(order_book);
+        } else {
+            OrderBook order_book(DEFAULT_TICK_SIZE, &queue_sink);
+            match(order_book);
+        }
+    });
+    thread printer([&] {
+        BookEvent event;
+        do events.pop(event);
+        while (dispatch_event(event, sink));
+        sink.write_out();
+        fflush(stdout);
+    });
+
+    TscClock clock;
+    auto start = chrono::steady_clock::now();
+    char side;
+    string quantity, price;
+    size_t orders = 0;
+    while (cin >> side >> quantity >> price) {
+        ParsedOrder order;
+        GatewayMessage message{};
+        message.result = parse_order(side, quantity, price, DEFAULT_TICK_SIZE, order);
+        if (message.result == ValidationResult::VALID)
+            message.request = OrderRequest::add(order.side, order.quantity, order.price, clock.now());
+        requests.push(message);
+        orders++;
+    }
+    requests.push(GatewayMessage{OrderRequest{}, ValidationResult::VALID, true});
+    matcher.join();
+    printer.join();
+    double seconds = max(chrono::duration<double>(chrono::steady_clock::now() - start).count(), 1e-9);
+
+    cerr << orders << " orders (" << sink.rejected << " rejected), " << sink.trades << " trades in "
+         << seconds << " s: " << static_cast<uint64_t>(orders / seconds) << " orders/sec, "
+         << static_cast<uint64_t>(sink.trades / seconds) << " trades/sec" << endl;
+}
+
+// Read orders as typed in the REPL from stdin and write them as OrderRecords. Returns the number written.
+size_t encode(ofstream& out) {
+    char side;
+    string quantity, price;
+    TscClock clock;
+    size_t written = 0;
+    while (cin >> side >> quantity >> price) {
+        ParsedOrder order;
+        if (parse_order(side, quantity, price, DEFAULT_TICK_SIZE, order) != ValidationResult::VALID) continue;
+        OrderRecord record{INVALID_ORDER_ID, order.quantity, order.price, clock.now(), order.side, {}, DEFAULT_ACCOUNT};
+        out.write(reinterpret_cast<const char*>(&record), sizeof(record));
+        written++;
+    }
+    return written;
+}
+
+int main(int argc, char* argv[]) {
+    bool        ladder = false, quiet = false, threaded = false, futex = false;
+    string_view replay_path, ingest_path, encode_path, journal_path, snapshot_path, feed_path;
+    ParsedOrder low{}, high{};
+    size_t      levels = SIZE_MAX;
+    for (int i = 1; i < argc; i++) {
+        string_view arg(argv[i]);
+        if (arg == "--ladder" && i + 2 < argc) {
+            // The price range is given as prices, e.g. "9.5 10.5", and parsed like any order price.
+            if (parse_order('B', "1", argv[i + 1], DEFAULT_TICK_SIZE, low)  != ValidationResult::VALID ||
+                parse_order('B', "1", argv[i + 2], DEFAULT_TICK_SIZE, high) != ValidationResult::VALID) {
+                cerr << "ERROR: Invalid price range" << endl;
+                return 1;
+            }
+            ladder = true;
+            i += 2;
+        } else if (arg == "--replay" && i + 1 < argc) {
+            replay_path = argv[++i];
+        } else if (arg == "--ingest" && i + 1 < argc) {
+            ingest_path = argv[++i];
+        } else if (arg == "--encode" && i + 1 < argc) {
+            encode_path = argv[++i];
+        } else if (arg == "--journal" && i + 1 < argc) {
+            journal_path = argv[++i];
+        } else if (arg == "--snapshot" && i + 1 < argc) {
+            snapshot_path = argv[++i];
+        } else if (arg == "--levels" && i + 1 < argc) {
+            if (!parse_positive(string_view(argv[++i]), levels)) {
+                cerr << "ERROR: Invalid number of levels" << endl;
+                return 1;
+            }
+        } else if (arg == "--feed" && i + 1 < argc) {
+            feed_path = argv[++i];
+        } else if (arg == "--pipeline") {
+            threaded = true;
+        } else if (arg == "--futex") {
+            futex = true;
+        } else if (arg == "--quiet") {
+            quiet = true;
+        } else {
+            cerr << "ERROR: Unknown argument " << arg << endl;
+            return 1;
+        }
+    }
+
+    if (!encode_path.empty()) {
+        ofstream out{string(encode_path), ios::binary};
+        if (!out) {
+            cerr << "ERROR: Cannot write " << encode_path << endl;
+            return 1;
+        }
+        cerr << encode(out) << " orders written" << endl;
+        return 0;
+    }
+
+    if (threaded) {
+        ReplaySink sink(DEFAULT_TICK_SIZE, !quiet);
+        if (futex) pipeline<FutexWait>(ladder, low.price, high.price, sink);
+        else       pipeline<SpinWait>(ladder, low.price, high.price, sink);
+        return 0;
+    }
+
+    if (!replay_path.empty() || !ingest_path.empty()) {
+        bool            text = !ingest_path.empty();
+        string_view     path = text ? ingest_path : replay_path;
+        MappedOrderFile file;
+        if (!file.open(string(path))) {
+            cerr << "ERROR: Cannot map " << path << endl;
+            return 1;
+        }
+        ofstream feed_out;
+        if (!feed_path.empty()) {
+            feed_out.open(string(feed_path), ios::binary);
+            if (!feed_out) {
+                cerr << "ERROR: Cannot write " << feed_path << endl;
+                return 1;
+            }
+        }
+        ReplaySink sink(DEFAULT_TICK_SIZE, !quiet);
+        L2FeedSink market_data(feed_out);
+        TeeSink    both(sink, market_data);
+        EventSink* book_sink = feed_path.empty() ? static_cast<EventSink*>(&sink) : &both;
+
+        auto feed = [&](auto& order_book) { text ? ingest(order_book, sink, file) : replay(order_book, sink, file); };
+        if (ladder) {
+            PriceLadderBook order_book(low.price, high.price, DEFAULT_TICK_SIZE, book_sink);
+            feed(order_book);
+        } else {
+            OrderBook order_book(DEFAULT_TICK_SIZE, book_sink);
+            feed(order_book);
+        }
+        if (!feed_path.empty()) cerr << market_data.sequence() << " market-data deltas written to " << feed_path << endl;
+        return 0;
+    }
+
+    BookFiles  files{string(journal_path), string(snapshot_path), Journal(), 0};
+    BookFiles* journaled = journal_path.empty() ? nullptr : &files;
+    auto interactive = [&](auto& order_book) {
+        if (journaled != nullptr && !restore(order_book, files)) {
+            cerr << "ERROR: Cannot open " << journal_path << endl;
+            return 1;
+        }
+        run(order_book, journaled, levels);
+        return 0;
+    };
+    if (ladder) {
+        PriceLadderBook order_book(low.price, high.price);
+        return interactive(order_book);
+    }
+
+    OrderBook order_book;
+    return interactive(order_book);
+}
@@ -0,0 +1,460 @@
+/*
+* Benchmark that replays the same synthetic workloads through every order book engine.
+*
+* For each workload and engine it reports:
+*   - throughput: requests per second over a plain replay into a fresh book
+*   - latency:    p50/p99/p99.9 of single requests, timed one by one in a second replay
+* A request is one add (with its matching) or one cancel/modify. The engines publish to a NullSink
+* (OrderBook, OrderBook32, PriceLadderBook) or print to a stream with no buffer (HeapOrderBook), so neither
+* formatting nor I/O is measured. HeapOrderBook has no cancel or modify and skips workloads with them.
+*
+* With --verify it first checks every engine against ReferenceBook (reference_book.hpp), a plain
+* map-of-deques book that shares no code with them, on each workload, on the mixed one (every order
+* type, cancels, modifies, sweeps, same-price pileups, reused ids) and on risk_limits, replayed with
+* the workload's risk limits (adds and modifies up past every limit). Engine and reference are driven
+* in lockstep with the same requests, and after every request (every burst for the batch path) the
+* results submit() returned, the trades and rejections so far and the depth must be identical; at the
+* end so must the resting orders, in priority order. HeapOrderBook has no ids, cancels, modifies or order
+* types: it is checked on the add-only workloads, on the quantity and price of its trades after every add
+* and on the volume of every level at the end. The first difference is reported and the benchmark exits
+* with status 1 before timing anything.
+*
+* Usage:
+*   ./order_book_bench                       // 200000 requests per workload, seed 1
+*   ./order_book_bench [--verify] <requests> <seed>
+*/
+
+#include "event_sink.hpp"
+#include "heap_order_book.hpp"
+#include "order_book.hpp"
+#include "price_ladder_book.hpp"
+#include "reference_book.hpp"
+#include "risk_checker.hpp"
+#include "workloads.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <span>
+#include <sstream>
+#include <string>
+#include <vector>
+using namespace std;
+
+using Clock = chrono::steady_clock;
+
+// Requests between two compactions, and between two snapshot/restore cycles, of the engines checked for them.
+const size_t COMPACT_INTERVAL = 5000;
+const size_t RESTORE_INTERVAL = 20000;
+
+// Requests per add_orders call of the batch engines.
+const size_t VERIFY_BURST = 64;
+
+struct Result {
+    double   requests_per_second;
+    uint64_t p50_ns, p99_ns, p99_9_ns;
+};
+
+// Adapts HeapOrderBook to submit(), the way main.cpp drives it: add, then match. Prints to out, or nowhere.
+class HeapEngine {
+private:
+    ostream       null_out{nullptr};
+    HeapOrderBook order_book;
+
+public:
+    explicit HeapEngine(ostream* out = nullptr) : order_book(out != nullptr ? *out : null_out) {}
+
+    void submit(const OrderRequest& request) {
+        float price = static_cast<float>(request.price) / static_cast<float>(DEFAULT_TICK_SIZE.scale());
+        order_book.add_order(request.side, static_cast<int>(request.quantity), price, static_cast<int>(request.timestamp));
+        order_book.execute_and_print_trades();
+    }
+
+    void print_order_book() { order_book.print_order_book(); }
+};
+
+// An engine under test: makes a fresh book for a workload and replays requests into it.
+struct Engine {
+    string name;
+    bool   supports_amends;
+    function<Result(const Workload&)> run;
+};
+
+// Keeps the trades and rejections of a book, for comparing engines.
+class TradeRecorder : public EventSink {
+public:
+    vector<TradeEvent>       trades;
+    vector<ValidationResult> rejects;
+
+    void on_trade(const TradeEvent& trade) override    { trades.push_back(trade); }
+    void on_reject(const RejectEvent& reject) override { rejects.push_back(reject.reason); }
+
+    void clear() {
+        trades.clear();
+        rejects.clear();
+    }
+};
+
+// A RiskChecker with the accounts and limits of a workload, or nullptr if it has none.
+unique_ptr<RiskChecker> workload_risk(const Workload& workload) {
+    if (workload.accounts == 0) return nullptr;
+    return make_unique<RiskChecker>(workload.accounts, workload.limits);
+}
+
+bool same_trades(const vector<TradeEvent>& a, const vector<TradeEvent>& b) {
+    return equal(a.begin(), a.end(), b.begin(), b.end(), [](const TradeEvent& x, const TradeEvent& y) {
+        return x.maker_id == y.maker_id && x.taker_id == y.taker_id && x.taker_side == y.taker_side &&
+               x.price == y.price && x.quantity == y.quantity;
+    });
+}
+
+bool same_depth(const DepthSnapshot& a, const DepthSnapshot& b) {
+    auto same_levels = [](const DepthLevel* x, const DepthLevel* y, uint32_t count) {
+        return equal(x, x + count, y, [](const DepthLevel& l, const DepthLevel& r) {
+            return l.price == r.price && l.quantity == r.quantity;
+        });
+    };
+    return a.bid_levels == b.bid_levels && a.ask_levels == b.ask_levels && same_levels(a.bids, b.bids, a.bid_levels) &&
+           same_levels(a.asks, b.asks, a.ask_levels);
+}
+
+// Resting orders as export_orders wrote them. The engines walk their prices in different directions, so
+// both lists are put in side then price order first; within a level they keep their time priority.
+bool same_orders(vector<OrderRecord> a, vector<OrderRecord> b) {
+    auto by_level = [](const OrderRecord& x, const OrderRecord& y) {
+        return x.side != y.side ? x.side < y.side : x.price < y.price;
+    };
+    stable_sort(a.begin(), a.end(), by_level);
+    stable_sort(b.begin(), b.end(), by_level);
+    return equal(a.begin(), a.end(), b.begin(), b.end(), [](const OrderRecord& x, const OrderRecord& y) {
+        return x.id == y.id && x.quantity == y.quantity && x.price == y.price && x.timestamp == y.timestamp &&
+               x.side == y.side && x.account == y.account;
+    });
+}
+
+// An engine checked against the reference, a burst of requests at a time.
+class CheckedEngine {
+public:
+    virtual ~CheckedEngine() = default;
+
+    // Apply a burst, writing what submit() would have returned for each request to ids.
+    virtual void apply(span<const OrderRequest> requests, span<OrderId> ids) = 0;
+    virtual DepthSnapshot depth() = 0;
+    virtual void export_orders(vector<OrderRecord>& orders) const = 0;
+};
+
+// A book fed one request at a time through submit(), compacted every compact_interval requests or
+// moved into a fresh book by export_orders/restore every restore_interval requests (0: never). A fresh
+// book gets a fresh RiskChecker of the workload, which restore() fills with the open quantities.
+template <class Book>
+class SubmitEngine : public CheckedEngine {
+private:
+    const Workload&              workload;
+    function<unique_ptr<Book>()> make_book;
+    unique_ptr<RiskChecker>      risk;
+    unique_ptr<Book>             order_book;
+    size_t                       compact_interval, restore_interval;
+    size_t                       applied = 0;
+
+public:
+    SubmitEngine(const Workload& workload, function<unique_ptr<Book>()> make_book, size_t compact_interval = 0,
+                 size_t restore_interval = 0)
+        : workload(workload), make_book(move(make_book)), risk(workload_risk(workload)), order_book(this->make_book()),
+          compact_interval(compact_interval), restore_interval(restore_interval) {
+        order_book->set_risk(risk.get());
+    }
+
+    void apply(span<const OrderRequest> requests, span<OrderId> ids) override {
+        for (size_t i = 0; i < requests.size(); i++) {
+            ids[i] = order_book->submit(requests[i]);
+            applied++;
+            if constexpr (requires { order_book->compact(); })
+                if (compact_interval != 0 && applied % compact_interval == 0) order_book->compact();
+            if (restore_interval != 0 && applied % restore_interval == 0) {
+                vector<OrderRecord> orders;
+                order_book->export_orders(orders);
+                unique_ptr<RiskChecker> restored_risk = workload_risk(workload);
+                unique_ptr<Book>        restored      = make_book();
+                restored->set_risk(restored_risk.get());
+                restored->restore(orders, order_book->next_id());
+                order_book = move(restored);
+                risk       = move(restored_risk);
+            }
+        }
+    }
+
+    DepthSnapshot depth() override { return order_book->depth(); }
+    void export_orders(vector<OrderRecord>& orders) const override { order_book->export_orders(orders); }
+};
+
+// A book fed each burst through add_orders.
+template <class Book>
+class BatchEngine : public CheckedEngine {
+private:
+    unique_ptr<RiskChecker> risk;
+    unique_ptr<Book>        order_book;
+
+public:
+    BatchEngine(const Workload& workload, unique_ptr<Book> order_book)
+        : risk(workload_risk(workload)), order_book(move(order_book)) {
+        this->order_book->set_risk(risk.get());
+    }
+
+    void apply(span<const OrderRequest> requests, span<OrderId> ids) override { order_book->add_orders(requests, ids); }
+    DepthSnapshot depth() override { return order_book->depth(); }
+    void export_orders(vector<OrderRecord>& orders) const override { order_book->export_orders(orders); }
+};
+
+struct CheckedCandidate {
+    string name;
+    size_t burst; // Requests applied between two comparisons.
+    function<unique_ptr<CheckedEngine>(const Workload&, EventSink*)> make;
+};
+
+/*
+* @brief
+* Replay a workload through the reference book and a candidate side by side.
+*
+* @return: empty if they agree throughout, otherwise what differed first and where.
+*/
+string first_difference(const Workload& workload, const CheckedCandidate& candidate) {
+    TradeRecorder reference_trades, candidate_trades;
+    ReferenceBook reference(DEFAULT_TICK_SIZE, &reference_trades);
+    if (workload.accounts != 0) reference.set_limits(workload.accounts, workload.limits);
+    auto engine = candidate.make(workload, &candidate_trades);
+
+    const auto&     requests = workload.requests;
+    vector<OrderId> expected(candidate.burst), got(candidate.burst);
+    for (size_t start = 0; start < requests.size(); start += candidate.burst) {
+        span<const OrderRequest> burst(requests.data() + start, min(candidate.burst, requests.size() - start));
+        for (size_t i = 0; i < burst.size(); i++) expected[i] = reference.submit(burst[i]);
+        engine->apply(burst, got);
+
+        string where = " at request " + to_string(start + 1);
+        for (size_t i = 0; i < burst.size(); i++)
+            if (expected[i] != got[i]) return "result differs at request " + to_string(start + i + 1);
+        if (!same_trades(reference_trades.trades, candidate_trades.trades)) return "trades differ" + where;
+        if (reference_trades.rejects != candidate_trades.rejects)          return "rejections differ" + where;
+        if (!same_depth(reference.depth(), engine->depth()))                  return "depth differs" + where;
+        reference_trades.clear();
+        candidate_trades.clear();
+    }
+
+    vector<OrderRecord> reference_orders, candidate_orders;
+    reference.export_orders(reference_orders);
+    engine->export_orders(candidate_orders);
+    if (!same_orders(reference_orders, candidate_orders)) return "resting orders differ at the end";
+    return "";
+}
+
+// A "<quantity>@<price>" cell as HeapOrderBook prints trades and levels, with the price in DEFAULT_TICK_SIZE units.
+DepthLevel parse_heap_cell(const string& cell) {
+    size_t at = cell.find('@');
+    return DepthLevel{llround(stod(cell.substr(at + 1)) * DEFAULT_TICK_SIZE.scale()), stoll(cell.substr(0, at))};
+}
+
+// The levels of a book printed by HeapOrderBook::print_order_book: one side of each row either side of the '|'.
+void parse_heap_levels(const string& text, vector<DepthLevel>& bids, vector<DepthLevel>& asks) {
+    istringstream lines(text);
+    string        line;
+    getline(lines, line); // The header.
+    while (getline(lines, line)) {
+        size_t bar = line.find('|');
+        if (bar == string::npos) continue;
+        string bid = line.substr(0, bar), ask = line.substr(bar + 1);
+        if (bid.find('@') != string::npos) bids.push_back(parse_heap_cell(bid));
+        if (ask.find('@') != string::npos) asks.push_back(parse_heap_cell(ask));
+    }
+}
+
+bool same_levels(const vector<DepthLevel>& a, const vector<DepthLevel>& b) {
+    return equal(a.begin(), a.end(), b.begin(), b.end(), [](const DepthLevel& x, const DepthLevel& y) {
+        return x.price == y.price && x.quantity == y.quantity;
+    });
+}
+
+/*
+* @brief
+* Replay an add-only workload through the reference book and HeapOrderBook side by side, comparing the
+* quantity and price of the trades of every add and, at the end, the volume of every level.
+*
+* @return: empty if they agree throughout, otherwise what differed first and where.
+*/
+string heap_difference(const Workload& workload) {
+    TradeRecorder reference_trades;
+    ReferenceBook reference(DEFAULT_TICK_SIZE, &reference_trades);
+    ostringstream printed;
+    HeapEngine    heap(&printed);
+
+    const auto& requests = workload.requests;
+    for (size_t i = 0; i < requests.size(); i++) {
+        reference.submit(requests[i]);
+        heap.submit(requests[i]);
+
+        vector<DepthLevel> trades;
+        istringstream      lines(printed.str());
+        for (string line; getline(lines, line);) trades.push_back(parse_heap_cell(line));
+        bool same = equal(trades.begin(), trades.end(), reference_trades.trades.begin(), reference_trades.trades.end(),
+                          [](const DepthLevel& x, const TradeEvent& y) {
+                              return x.price == y.price && x.quantity == y.quantity;
+                          });
+        if (!same) return "trades differ at request " + to_string(i + 1);
+        reference_trades.clear();
+        printed.str("");
+    }
+
+    heap.print_order_book();
+    vector<DepthLevel> bids, asks;
+    parse_heap_levels(printed.str(), bids, asks);
+    if (!same_levels(bids, reference.levels('B')) || !same_levels(asks, reference.levels('S')))
+        return "levels differ at the end";
+    return "";
+}
+
+// Check every engine on every workload. Returns false if any of them differs from the reference.
+bool verify(const vector<Workload>& workloads) {
+    auto ladder = [](const Workload& workload, EventSink* sink) {
+        return make_unique<PriceLadderBook>(workload.min_price, workload.max_price, DEFAULT_TICK_SIZE, sink);
+    };
+    vector<CheckedCandidate> candidates = {
+        {"OrderBook", 1, [](const Workload& workload, EventSink* sink) -> unique_ptr<CheckedEngine> {
+            return make_unique<SubmitEngine<OrderBook>>(workload,
+                                                        [sink] { return make_unique<OrderBook>(DEFAULT_TICK_SIZE, sink); });
+        }},
+        {"OrderBook32", 1, [](const Workload& workload, EventSink* sink) -> unique_ptr<CheckedEngine> {
+            return make_unique<SubmitEngine<OrderBook32>>(workload,
+                                                          [sink] { return make_unique<OrderBook32>(DEFAULT_TICK_SIZE, sink); });
+        }},
+        {"PriceLadderBook", 1, [&](const Workload& workload, EventSink* sink) -> unique_ptr<CheckedEngine> {
+            return make_unique<SubmitEngine<PriceLadderBook>>(workload, [&, sink] { return ladder(workload, sink); });
+        }},
+        {"OrderBook batch", VERIFY_BURST, [](const Workload& workload, EventSink* sink) -> unique_ptr<CheckedEngine> {
+            return make_unique<BatchEngine<OrderBook>>(workload, make_unique<OrderBook>(DEFAULT_TICK_SIZE, sink));
+        }},
+        {"PriceLadderBook batch", VERIFY_BURST, [&](const Workload& workload, EventSink* sink) -> unique_ptr<CheckedEngine> {
+            return make_unique<BatchEngine<PriceLadderBook>>(workload, ladder(workload, sink));
+        }},
+        {"OrderBook32 batch", VERIFY_BURST, [](const Workload& workload, EventSink* sink) -> unique_ptr<CheckedEngine> {
+            return make_unique<BatchEngine<OrderBook32>>(workload, make_unique<OrderBook32>(DEFAULT_TICK_SIZE, sink));
+        }},
+        {"OrderBook compacted", 1, [](const Workload& workload, EventSink* sink) -> unique_ptr<CheckedEngine> {
+            return make_unique<SubmitEngine<OrderBook>>(
+                workload, [sink] { return make_unique<OrderBook>(DEFAULT_TICK_SIZE, sink); }, COMPACT_INTERVAL);
+        }},
+        {"OrderBook restored", 1, [](const Workload& workload, EventSink* sink) -> unique_ptr<CheckedEngine> {
+            return make_unique<SubmitEngine<OrderBook>>(
+                workload, [sink] { return make_unique<OrderBook>(DEFAULT_TICK_SIZE, sink); }, 0, RESTORE_INTERVAL);
+        }},
+        {"PriceLadderBook restored", 1, [&](const Workload& workload, EventSink* sink) -> unique_ptr<CheckedEngine> {
+            return make_unique<SubmitEngine<PriceLadderBook>>(workload, [&, sink] { return ladder(workload, sink); }, 0,
+                                                              RESTORE_INTERVAL);
+        }},
+    };
+
+    bool all_same = true;
+    auto report = [&](const Workload& workload, const string& engine, const string& difference) {
+        printf("%-14s %-26s %s\n", workload.name.c_str(), engine.c_str(), difference.empty() ? "same" : difference.c_str());
+        all_same = all_same && difference.empty();
+    };
+    printf("%-14s %-26s %s\n", "workload", "engine", "against ReferenceBook");
+    for (const Workload& workload : workloads) {
+        for (const CheckedCandidate& candidate : candidates)
+            report(workload, candidate.name, first_difference(workload, candidate));
+        if (workload.has_amends) printf("%-14s %-26s %s\n", workload.name.c_str(), "HeapOrderBook", "n/a");
+        else                     report(workload, "HeapOrderBook", heap_difference(workload));
+    }
+    printf("\n");
+    return all_same;
+}
+
+uint64_t percentile(const vector<uint64_t>& sorted, double fraction) {
+    return sorted[min(sorted.size() - 1, static_cast<size_t>(fraction * sorted.size()))];
+}
+
+template <class MakeBook>
+Result measure(const Workload& workload, MakeBook make_book) {
+    const auto& requests = workload.requests;
+    Result result{};
+    {
+        auto order_book = make_book();
+        auto start      = Clock::now();
+        for (const OrderRequest& request : requests) order_book->submit(request);
+        double seconds  = chrono::duration<double>(Clock::now() - start).count();
+        result.requests_per_second = requests.size() / max(seconds, 1e-9);
+    }
+
+    vector<uint64_t> latencies(requests.size());
+    {
+        auto order_book = make_book();
+        for (size_t i = 0; i < requests.size(); i++) {
+            auto start = Clock::now();
+            order_book->submit(requests[i]);
+            latencies[i] = chrono::duration_cast<chrono::nanoseconds>(Clock::now() - start).count();
+        }
+    }
+    sort(latencies.begin(), latencies.end());
+    result.p50_ns   = percentile(latencies, 0.50);
+    result.p99_ns   = percentile(latencies, 0.99);
+    result.p99_9_ns = percentile(latencies, 0.999);
+    return result;
+}
+
+int main(int argc, char* argv[]) {
+    bool check = argc > 1 && string(argv[1]) == "--verify";
+    if (check) {
+        argc--;
+        argv++;
+    }
+    size_t   requests = argc > 1 ? strtoull(argv[1], nullptr, 10) : 200000;
+    uint64_t seed     = argc > 2 ? strtoull(argv[2], nullptr, 10) : 1;
+    if (requests == 0) {
+        cerr << "ERROR: Number of requests should be a positive integer" << endl;
+        return 1;
+    }
+
+    if (check) {
+        vector<Workload> workloads = all_workloads(requests, seed);
+        workloads.push_back(mixed(requests, seed));
+        workloads.push_back(risk_limits(requests, seed));
+        if (!verify(workloads)) {
+            cerr << "ERROR: An engine differs from the reference book" << endl;
+            return 1;
+        }
+    }
+
+    static NullSink sink;
+    vector<Engine> engines = {
+        {"OrderBook", true, [](const Workload& workload) {
+            return measure(workload, [] { return make_unique<OrderBook>(DEFAULT_TICK_SIZE, &sink); });
+        }},
+        {"OrderBook32", true, [](const Workload& workload) {
+            return measure(workload, [] { return make_unique<OrderBook32>(DEFAULT_TICK_SIZE, &sink); });
+        }},
+        {"PriceLadderBook", true, [](const Workload& workload) {
+            return measure(workload, [&] {
+                return make_unique<PriceLadderBook>(workload.min_price, workload.max_price, DEFAULT_TICK_SIZE, &sink);
+            });
+        }},
+        {"HeapOrderBook", false, [](const Workload& workload) {
+            return measure(workload, [] { return make_unique<HeapEngine>(); });
+        }},
+    };
+
+    printf("%zu requests per workload, seed %llu\n\n", requests, static_cast<unsigned long long>(seed));
+    printf("%-14s %-16s %14s %10s %10s %10s\n", "workload", "engine", "requests/s", "p50 ns", "p99 ns", "p99.9 ns");
+    for (const Workload& workload : all_workloads(requests, seed)) {
+        for (const Engine& engine : engines) {
+            if (workload.has_amends && !engine.supports_amends) {
+                printf("%-14s %-16s %14s\n", workload.name.c_str(), engine.name.c_str(), "n/a");
+                continue;
+            }
+            Result result = engine.run(workload);
+            printf("%-14s %-16s %14.0f %10llu %10llu %10llu\n", workload.name.c_str(), engine.name.c_str(),
+                   result.requests_per_second, static_cast<unsigned long long>(result.p50_ns),
+                   static_cast<unsigned long long>(result.p99_ns), static_cast<unsigned long long>(result.p99_9_ns));
+        }
+    }
+}
@@ -0,0 +1,270 @@
+/*
+* Defines ReferenceBook, the plain price-time order book the benchmark checks every engine against.
+*
+* It is written to be obviously right rather than fast, and shares no code with the engines it checks:
+* each side is a map from price to a deque of orders, best price first; an order is found for a cancel
+* or modify by scanning every level; the fill loop takes the front order of the best level one trade at
+* a time; and validation and the risk limits are done inline here, not by validate_order or RiskChecker.
+* Only the request, event and record structs are shared, so a bug in the pools, the intrusive queues, the
+* sweep fast path, LevelFill or the risk checks shows up as a difference.
+*
+* It follows the rules of OrderBook (price-time priority, no self-trade prevention): rejections in the
+* order side, quantity, price, duplicate id, risk limits, post-only cross, fill-or-kill liquidity; ids the
+* book assigns itself above any id chosen by a caller; a modify down keeps the order's place, a modify up
+* sends it to the back of its level.
+*
+* Usage:
+*   TradeRecorder events;
+*   ReferenceBook reference(DEFAULT_TICK_SIZE, &events);
+*   reference.set_limits(8, AccountLimits{150, 1'400'000, 1000});
+*   OrderId id = reference.submit(OrderRequest::add('B', 50, 10390, 1, 1));
+*/
+
+#pragma once
+
+#include "depth_cache.hpp"
+#include "event_sink.hpp"
+#include "order_parser.hpp"
+#include "order_pool.hpp"
+#include "order_record.hpp"
+#include "order_request.hpp"
+#include "price.hpp"
+#include "risk_checker.hpp"
+#include <algorithm>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <map>
+#include <vector>
+using namespace std;
+
+class ReferenceBook {
+    /*
+    * Price-time order book on std::map and std::deque, with no optimization of any kind.
+    */
+
+private:
+    struct Order {
+        OrderId   id;
+        Quantity  quantity;
+        Price     price;
+        long      timestamp;
+        char      side;
+        AccountId account;
+    };
+
+    map<Price, deque<Order>, greater<Price>> bids; // Highest price first.
+    map<Price, deque<Order>>                 asks; // Lowest price first.
+
+    TickSize   tick_size;
+    EventSink* sink;
+    OrderId    next_order_id = 1;
+
+    // Risk limits, off while accounts is 0. open holds the remaining quantity resting per account.
+    size_t           accounts = 0;
+    AccountLimits    limits{};
+    vector<Quantity> open;
+
+    // Whether a limit order of side at price would trade against the best level of the other side.
+    bool crosses(char side, Price price) const {
+        return side == 'B' ? !asks.empty() && asks.begin()->first <= price
+                           : !bids.empty() && bids.begin()->first >= price;
+    }
+
+    // Whether an order of side at price could be filled in full by the other side.
+    bool can_fill(char side, Quantity quantity, Price price) const {
+        Quantity total = 0;
+        auto add_up = [&](const auto& levels) {
+            for (const auto& [level_price, queue] : levels) {
+                if (side == 'B' ? level_price > price : level_price < price) break;
+                for (const Order& order : queue) total += order.quantity;
+            }
+        };
+        side == 'B' ? add_up(asks) : add_up(bids);
+        return total >= quantity;
+    }
+
+    // The risk limits of an order of quantity at price, of which increase would be added to the open quantity.
+    ValidationResult check_limits(AccountId account, Quantity quantity, Price price, bool priced, Quantity increase) const {
+        if (accounts == 0) return ValidationResult::VALID;
+        if (account >= accounts) return ValidationResult::UNKNOWN_ACCOUNT;
+        if (quantity > limits.max_order_quantity) return ValidationResult::ORDER_QUANTITY_LIMIT;
+        __extension__ using Wide = __int128;
+        if (priced && static_cast<Wide>(quantity) * price > limits.max_order_notional) return ValidationResult::NOTIONAL_LIMIT;
+        if (open[account] + static_cast<Wide>(increase) > limits.max_open_quantity) return ValidationResult::EXPOSURE_LIMIT;
+        return ValidationResult::VALID;
+    }
+
+    void change_open(AccountId account, Quantity change) {
+        if (accounts != 0) open[account] += change;
+    }
+
+    // Trade an incoming order against the other side, best level first, while it crosses. Returns what is left.
+    template <class Levels>
+    Quantity match(Levels& levels, OrderId id, char side, Quantity quantity, Price limit) {
+        while (quantity > 0 && !levels.empty()) {
+            auto level = levels.begin();
+            if (side == 'B' ? level->first > limit : level->first < limit) break;
+
+            Order&   maker  = level->second.front();
+            Quantity traded = min(quantity, maker.quantity);
+            sink->on_trade(TradeEvent{maker.id, id, side, maker.price, traded});
+            change_open(maker.account, -traded);
+            maker.quantity -= traded;
+            quantity       -= traded;
+            if (maker.quantity == 0) level->second.pop_front();
+            if (level->second.empty()) levels.erase(level);
+        }
+        return quantity;
+    }
+
+    // Find a resting order by scanning both sides. Calls found(levels, level, position) if it is there.
+    template <class Found>
+    bool find(OrderId id, Found found) {
+        auto search = [&](auto& levels) {
+            for (auto level = levels.begin(); level != levels.end(); ++level)
+                for (auto order = level->second.begin(); order != level->second.end(); ++order)
+                    if (order->id == id) {
+                        found(levels, level, order);
+                        return true;
+                    }
+            return false;
+        };
+        return search(bids) || search(asks);
+    }
+
+    // Why an add is refused, checked in the same order as OrderBook.
+    ValidationResult validate(const OrderRequest& request) {
+        bool priced = request.order_type != OrderType::MARKET;
+        if (request.side != 'B' && request.side != 'S') return ValidationResult::INVALID_SIDE;
+        if (request.quantity <= 0) return ValidationResult::INVALID_QUANTITY;
+        if (priced && (request.price < tick_size.units || request.price % tick_size.units != 0))
+            return ValidationResult::INVALID_PRICE;
+        if (request.id != INVALID_ORDER_ID && find(request.id, [](auto&, auto, auto) {}))
+            return ValidationResult::DUPLICATE_ORDER_ID;
+
+        ValidationResult result = check_limits(request.account, request.quantity, request.price, priced, request.quantity);
+        if (result != ValidationResult::VALID) return result;
+
+        if (request.order_type == OrderType::POST_ONLY && crosses(request.side, request.price))
+            return ValidationResult::WOULD_CROSS;
+        if (request.order_type == OrderType::FOK && !can_fill(request.side, request.quantity, request.price))
+            return ValidationResult::INSUFFICIENT_LIQUIDITY;
+        return ValidationResult::VALID;
+    }
+
+    OrderId add(const OrderRequest& request) {
+        ValidationResult result = validate(request);
+        if (result != ValidationResult::VALID) {
+            sink->on_reject(RejectEvent{result});
+            return INVALID_ORDER_ID;
+        }
+
+        OrderId id = request.id;
+        if (id == INVALID_ORDER_ID) id = next_order_id++;
+        else                        next_order_id = max(next_order_id, id + 1);
+
+        Price limit = request.order_type != OrderType::MARKET ? request.price
+                    : request.side == 'B' ? numeric_limits<Price>::max() : numeric_limits<Price>::min();
+        Quantity remaining = request.side == 'B' ? match(asks, id, request.side, request.quantity, limit)
+                                                 : match(bids, id, request.side, request.quantity, limit);
+
+        bool rests = request.order_type == OrderType::LIMIT || request.order_type == OrderType::POST_ONLY;
+        if (remaining > 0 && rests) {
+            Order order{id, remaining, request.price, request.timestamp, request.side, request.account};
+            request.side == 'B' ? bids[request.price].push_back(order) : asks[request.price].push_back(order);
+            change_open(request.account, remaining);
+        }
+        return id;
+    }
+
+    OrderId cancel(OrderId id) {
+        return find(id, [&](auto& levels, auto level, auto order) {
+            change_open(order->account, -order->quantity);
+            level->second.erase(order);
+            if (level->second.empty()) levels.erase(level);
+        }) ? id : INVALID_ORDER_ID;
+    }
+
+    OrderId modify(OrderId id, Quantity new_quantity) {
+        if (new_quantity <= 0) return INVALID_ORDER_ID;
+        bool accepted = false;
+        find(id, [&](auto&, auto level, auto order) {
+            Quantity increase = new_quantity - order->quantity;
+            if (increase > 0) {
+                ValidationResult result = check_limits(order->account, new_quantity, order->price, true, increase);
+                if (result != ValidationResult::VALID) {
+                    sink->on_reject(RejectEvent{result});
+                    return;
+                }
+            }
+            accepted = true;
+            change_open(order->account, increase);
+            if (increase <= 0) {
+                order->quantity = new_quantity;
+                return;
+            }
+            Order moved    = *order;
+            moved.quantity = new_quantity;
+            level->second.erase(order);
+            level->second.push_back(moved);
+        });
+        return accepted ? id : INVALID_ORDER_ID;
+    }
+
+public:
+    ReferenceBook(TickSize tick_size, EventSink* sink) : tick_size(tick_size), sink(sink) {}
+
+    // Hold orders to limits, as a book with RiskChecker(account_count, account_limits) would.
+    void set_limits(size_t account_count, const AccountLimits& account_limits) {
+        accounts = account_count;
+        limits   = account_limits;
+        open.assign(account_count, 0);
+    }
+
+    // Apply a request. Returns what OrderBook::submit returns for it.
+    OrderId submit(const OrderRequest& request) {
+        switch (request.type) {
+            case RequestType::ADD:    return add(request);
+            case RequestType::CANCEL: return cancel(request.id);
+            case RequestType::MODIFY: return modify(request.id, request.quantity);
+        }
+        return INVALID_ORDER_ID;
+    }
+
+    // Every level of a side, best first, with its total quantity.
+    vector<DepthLevel> levels(char side) const {
+        vector<DepthLevel> out;
+        auto add_up = [&](const auto& side_levels) {
+            for (const auto& [price, queue] : side_levels) {
+                Quantity total = 0;
+                for (const Order& order : queue) total += order.quantity;
+                out.push_back(DepthLevel{price, total});
+            }
+        };
+        side == 'B' ? add_up(bids) : add_up(asks);
+        return out;
+    }
+
+    DepthSnapshot depth() const {
+        DepthSnapshot      snapshot{};
+        vector<DepthLevel> bid_levels = levels('B'), ask_levels = levels('S');
+        snapshot.bid_levels = static_cast<uint32_t>(min(bid_levels.size(), MAX_DEPTH));
+        snapshot.ask_levels = static_cast<uint32_t>(min(ask_levels.size(), MAX_DEPTH));
+        copy_n(bid_levels.begin(), snapshot.bid_levels, snapshot.bids);
+        copy_n(ask_levels.begin(), snapshot.ask_levels, snapshot.asks);
+        return snapshot;
+    }
+
+    // Resting orders, buys then sells, each side best price first and in time priority within a level.
+    void export_orders(vector<OrderRecord>& orders) const {
+        auto export_side = [&](const auto& side_levels) {
+            for (const auto& [price, queue] : side_levels)
+                for (const Order& order : queue)
+                    orders.push_back(OrderRecord{order.id, order.quantity, order.price, order.timestamp, order.side, {},
+                                                 order.account});
+        };
+        export_side(bids);
+        export_side(asks);
+    }
+};
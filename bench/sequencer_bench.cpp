@@ -0,0 +1,118 @@
+/*
+* Benchmark of multi-producer ingest through a Sequencer into a sharded StockOrderBook.
+*
+* For 1, 2, 4, 8 and 16 producer threads it replays the same total number of requests and reports the
+* throughput from the first submit to the moment every book has processed everything. The random_walk
+* flows of 64 symbols are split into 16 groups, and with n producers producer p submits groups p, p + n,
+* ... - so every run feeds the same flows into the same books and only the number of threads changes. The direct line is one
+* thread calling StockOrderBook::submit() with no sequencer, for comparison. Books publish to a NullSink.
+*
+* Usage:
+*   ./sequencer_bench                        // 1000000 requests, 4 shards
+*   ./sequencer_bench <requests> <shards>
+*/
+
+#include "order_request.hpp"
+#include "sequencer.hpp"
+#include "stock_order_book.hpp"
+#include "workloads.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+using namespace std;
+
+using Clock = chrono::steady_clock;
+
+// Most producers measured; also the number of symbol groups the flows are split into.
+const size_t MAX_PRODUCERS = 16;
+
+// Symbols of each group.
+const size_t SYMBOLS_PER_GROUP = 4;
+
+// A request of a flow, with the symbol it is for.
+struct SymbolRequest {
+    SymbolId     symbol;
+    OrderRequest request;
+};
+
+// The flows of one symbol group, interleaved symbol by symbol: group g holds symbols g, g + 16, ...
+vector<SymbolRequest> group_flow(size_t group, size_t requests) {
+    vector<Workload> workloads;
+    for (size_t i = 0; i < SYMBOLS_PER_GROUP; i++)
+        workloads.push_back(random_walk(requests / SYMBOLS_PER_GROUP, 1 + group * SYMBOLS_PER_GROUP + i));
+
+    vector<SymbolRequest> flow;
+    flow.reserve(requests);
+    for (size_t j = 0; j < requests / SYMBOLS_PER_GROUP; j++)
+        for (size_t i = 0; i < SYMBOLS_PER_GROUP; i++)
+            flow.push_back(SymbolRequest{static_cast<SymbolId>(group + i * MAX_PRODUCERS), workloads[i].requests[j]});
+    return flow;
+}
+
+void add_symbols(StockOrderBook& stocks) {
+    for (size_t i = 0; i < MAX_PRODUCERS * SYMBOLS_PER_GROUP; i++) stocks.add_symbol("S" + to_string(i));
+}
+
+// One thread submits every group itself, straight into the StockOrderBook.
+double run_direct(const vector<vector<SymbolRequest>>& groups, size_t shards) {
+    StockOrderBook stocks(shards, DEFAULT_TICK_SIZE, {}, false);
+    add_symbols(stocks);
+    stocks.start();
+
+    auto start = Clock::now();
+    for (const auto& flow : groups)
+        for (const SymbolRequest& entry : flow) stocks.submit(entry.symbol, entry.request);
+    stocks.wait_idle();
+    return chrono::duration<double>(Clock::now() - start).count();
+}
+
+// producers threads split the groups between them and submit through a Sequencer.
+double run_sequenced(const vector<vector<SymbolRequest>>& groups, size_t shards, size_t producers) {
+    StockOrderBook stocks(shards, DEFAULT_TICK_SIZE, {}, false);
+    add_symbols(stocks);
+    Sequencer sequencer(stocks, producers);
+    stocks.start();
+    sequencer.start();
+
+    atomic<bool>   go{false};
+    vector<thread> threads;
+    for (size_t p = 0; p < producers; p++) {
+        threads.emplace_back([&, p] {
+            while (!go.load(memory_order_acquire)) cpu_relax();
+            for (size_t group = p; group < groups.size(); group += producers)
+                for (const SymbolRequest& entry : groups[group]) sequencer.submit(p, entry.symbol, entry.request);
+        });
+    }
+
+    auto start = Clock::now();
+    go.store(true, memory_order_release);
+    for (thread& producer : threads) producer.join();
+    sequencer.wait_idle();
+    return chrono::duration<double>(Clock::now() - start).count();
+}
+
+int main(int argc, char* argv[]) {
+    size_t requests = argc > 1 ? strtoull(argv[1], nullptr, 10) : 1000000;
+    size_t shards   = argc > 2 ? strtoull(argv[2], nullptr, 10) : 4;
+    if (requests < MAX_PRODUCERS * SYMBOLS_PER_GROUP || shards == 0) {
+        cerr << "ERROR: Need at least " << MAX_PRODUCERS * SYMBOLS_PER_GROUP << " requests and one shard" << endl;
+        return 1;
+    }
+
+    vector<vector<SymbolRequest>> groups;
+    for (size_t group = 0; group < MAX_PRODUCERS; group++) groups.push_back(group_flow(group, requests / MAX_PRODUCERS));
+    size_t total = 0;
+    for (const auto& flow : groups) total += flow.size();
+
+    printf("%zu requests over %zu symbols, %zu shards, %u hardware threads\n\n", total,
+           MAX_PRODUCERS * SYMBOLS_PER_GROUP, shards, thread::hardware_concurrency());
+    printf("%-10s %14s\n", "producers", "requests/s");
+    printf("%-10s %14.0f\n", "direct", total / run_direct(groups, shards));
+    for (size_t producers = 1; producers <= MAX_PRODUCERS; producers *= 2)
+        printf("%-10zu %14.0f\n", producers, total / run_sequenced(groups, shards, producers));
+}
@@ -0,0 +1,229 @@
+/*
+* Synthetic order flows for the benchmarks, one generator per market situation.
+*
+* Every generator is deterministic for a given seed, gives each add a unique timestamp and a
+* caller-chosen id (its position in the flow, from 1), and keeps all prices inside the
+* workload's [min_price, max_price] so a PriceLadderBook can replay it too. A workload with accounts
+* is meant for books with a RiskChecker of that many accounts, each with the workload's limits.
+*
+* Usage:
+*   Workload workload = random_walk(100000, 1);
+*   for (const OrderRequest& request : workload.requests) order_book.submit(request);
+*/
+
+#pragma once
+
+#include "order_request.hpp"
+#include "price.hpp"
+#include "risk_checker.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+using namespace std;
+
+// Prices of the workloads are in units of DEFAULT_TICK_SIZE (0.001) around 10.000.
+const Price WORKLOAD_MID = 10000;
+
+struct Workload {
+    string               name;
+    vector<OrderRequest> requests;
+    Price                min_price;
+    Price                max_price;
+    bool                 has_amends = false; // Contains cancels or modifies.
+    size_t               accounts   = 0;     // Accounts of the orders, each held to limits; 0: no risk checks.
+    AccountLimits        limits{};
+};
+
+namespace workload_detail {
+    inline OrderRequest add(vector<OrderRequest>& requests, char side, Quantity quantity, Price price) {
+        OrderId id = requests.size() + 1;
+        return OrderRequest::add(side, quantity, price, static_cast<long>(id), id);
+    }
+}
+
+/*
+* Passive orders pile up at two prices per side, so the level queues grow long, and one order in ten
+* crosses the spread for a small part of a queue.
+*/
+inline Workload deep_queue(size_t orders, uint64_t seed) {
+    Workload workload{"deep_queue", {}, WORKLOAD_MID - 2, WORKLOAD_MID + 2};
+    mt19937_64 random(seed);
+    workload.requests.reserve(orders);
+    for (size_t i = 0; i < orders; i++) {
+        char side       = random() % 2 ? 'B' : 'S';
+        bool aggressive = random() % 10 == 0;
+        Price offset    = aggressive ? -2 : 1 + static_cast<Price>(random() % 2);
+        Price price     = side == 'B' ? WORKLOAD_MID - offset : WORKLOAD_MID + offset;
+        Quantity quantity = 1 + static_cast<Quantity>(random() % (aggressive ? 200 : 100));
+        workload.requests.push_back(workload_detail::add(workload.requests, side, quantity, price));
+    }
+    return workload;
+}
+
+/*
+* Passive orders spread over 200 levels per side, and one order in 100 is large enough to sweep
+* through dozens of levels of the opposite side.
+*/
+inline Workload sweep(size_t orders, uint64_t seed) {
+    const Price LEVELS = 200;
+    Workload workload{"sweep", {}, WORKLOAD_MID - LEVELS, WORKLOAD_MID + LEVELS};
+    mt19937_64 random(seed);
+    workload.requests.reserve(orders);
+    for (size_t i = 0; i < orders; i++) {
+        char side = random() % 2 ? 'B' : 'S';
+        if (random() % 100 == 0) {
+            Price limit = side == 'B' ? WORKLOAD_MID + LEVELS : WORKLOAD_MID - LEVELS;
+            workload.requests.push_back(workload_detail::add(workload.requests, side, 5000, limit));
+            continue;
+        }
+        Price offset = 1 + static_cast<Price>(random() % LEVELS);
+        Price price  = side == 'B' ? WORKLOAD_MID - offset : WORKLOAD_MID + offset;
+        workload.requests.push_back(workload_detail::add(workload.requests, side, 1 + random() % 100, price));
+    }
+    return workload;
+}
+
+/*
+* Mostly passive orders 50 levels either side of the mid, where four requests in five cancel or
+* amend an earlier order - most orders never trade.
+*/
+inline Workload cancel_heavy(size_t orders, uint64_t seed) {
+    const Price LEVELS = 50;
+    Workload workload{"cancel_heavy", {}, WORKLOAD_MID - LEVELS, WORKLOAD_MID + LEVELS, true};
+    mt19937_64 random(seed);
+    vector<OrderId> live;
+    workload.requests.reserve(orders);
+    while (workload.requests.size() < orders) {
+        uint64_t roll = random() % 10;
+        if (roll < 8 && !live.empty()) {
+            // Amend a random earlier order; it may already have traded, which every engine rejects alike.
+            size_t  pick = random() % live.size();
+            OrderId id   = live[pick];
+            if (roll < 6) {
+                live[pick] = live.back();
+                live.pop_back();
+                workload.requests.push_back(OrderRequest::cancel(id));
+            } else {
+                workload.requests.push_back(OrderRequest::modify(id, 1 + random() % 100));
+            }
+            continue;
+        }
+        char  side   = random() % 2 ? 'B' : 'S';
+        Price offset = static_cast<Price>(random() % LEVELS) - 2; // Slightly crossing now and then.
+        Price price  = side == 'B' ? WORKLOAD_MID - offset : WORKLOAD_MID + offset;
+        OrderRequest request = workload_detail::add(workload.requests, side, 1 + random() % 100, price);
+        live.push_back(request.id);
+        workload.requests.push_back(request);
+    }
+    return workload;
+}
+
+/*
+* The mid drifts one tick at a time, and orders land on either side of it, so levels keep appearing
+* ahead of the best price and trades happen at every depth of the touch.
+*/
+inline Workload random_walk(size_t orders, uint64_t seed) {
+    const Price DRIFT = 1000, SPREAD = 20;
+    Workload workload{"random_walk", {}, WORKLOAD_MID - DRIFT - SPREAD, WORKLOAD_MID + DRIFT + SPREAD};
+    mt19937_64 random(seed);
+    Price mid = WORKLOAD_MID;
+    workload.requests.reserve(orders);
+    for (size_t i = 0; i < orders; i++) {
+        mid = clamp<Price>(mid + static_cast<Price>(random() % 3) - 1, WORKLOAD_MID - DRIFT, WORKLOAD_MID + DRIFT);
+        char  side   = random() % 2 ? 'B' : 'S';
+        Price offset = static_cast<Price>(random() % (2 * SPREAD + 1)) - SPREAD;
+        workload.requests.push_back(workload_detail::add(workload.requests, side, 1 + random() % 100, mid + offset));
+    }
+    return workload;
+}
+
+/*
+* Every kind of request the books take, for checking engines against each other rather than timing them:
+* limit orders and every other order type, pileups of orders at one price per side, sweeps through dozens
+* of levels, cancels and modifies up and down (some of orders that already traded), and adds that reuse
+* the id of an earlier order, resting or not.
+*/
+inline Workload mixed(size_t orders, uint64_t seed) {
+    const Price LEVELS = 30;
+    const OrderType TYPES[] = {OrderType::MARKET, OrderType::IOC, OrderType::FOK, OrderType::POST_ONLY};
+    Workload workload{"mixed", {}, WORKLOAD_MID - 2 * LEVELS, WORKLOAD_MID + 2 * LEVELS, true};
+    mt19937_64 random(seed);
+    vector<OrderId> ids;
+    workload.requests.reserve(orders);
+    while (workload.requests.size() < orders) {
+        uint64_t roll = random() % 100;
+        if (roll < 25 && !ids.empty()) {
+            OrderId id = ids[random() % ids.size()];
+            if (roll < 15) workload.requests.push_back(OrderRequest::cancel(id));
+            else           workload.requests.push_back(OrderRequest::modify(id, 1 + random() % 150));
+            continue;
+        }
+
+        char     side     = random() % 2 ? 'B' : 'S';
+        Quantity quantity = 1 + static_cast<Quantity>(random() % 100);
+        Price    offset   = static_cast<Price>(random() % LEVELS) - 3;       // Crossing now and then.
+        uint64_t shape    = random() % 10;
+        if (shape == 0) {
+            offset   = -2 * LEVELS;                                           // Sweep the opposite side.
+            quantity = 300 + static_cast<Quantity>(random() % 1500);
+        } else if (shape < 4) {
+            offset   = 1;                                                     // Pile up at the same price.
+        }
+        Price        price   = side == 'B' ? WORKLOAD_MID - offset : WORKLOAD_MID + offset;
+        OrderRequest request = workload_detail::add(workload.requests, side, quantity, price);
+        if (random() % 5 == 0)       request.order_type = TYPES[random() % 4];
+        if (roll < 28 && !ids.empty()) request.id       = ids[random() % ids.size()];
+        ids.push_back(request.id);
+        workload.requests.push_back(request);
+    }
+    return workload;
+}
+
+/*
+* Orders of a few accounts held to tight limits, for checking the risk checks of engines against each other:
+* adds over the quantity or notional limit and adds of an unknown account, and modifies that raise orders
+* past either limit - some to a billion lots - or past the open quantity limit, as well as modifies down.
+*/
+inline Workload risk_limits(size_t orders, uint64_t seed) {
+    const Price  LEVELS   = 30;
+    const size_t ACCOUNTS = 8;
+    Workload workload{"risk_limits", {}, WORKLOAD_MID - LEVELS, WORKLOAD_MID + LEVELS, true, ACCOUNTS,
+                      AccountLimits{150, 140 * WORKLOAD_MID, 1000}};
+    mt19937_64 random(seed);
+    vector<OrderId> live;
+    workload.requests.reserve(orders);
+    while (workload.requests.size() < orders) {
+        uint64_t roll = random() % 100;
+        if (roll < 60 && !live.empty()) {
+            size_t  pick = random() % live.size();
+            OrderId id   = live[pick];
+            if (roll < 40) {
+                live[pick] = live.back();
+                live.pop_back();
+                workload.requests.push_back(OrderRequest::cancel(id));
+            } else if (roll < 42) {
+                workload.requests.push_back(OrderRequest::modify(id, 1'000'000'000));
+            } else {
+                workload.requests.push_back(OrderRequest::modify(id, 1 + random() % 170));
+            }
+            continue;
+        }
+
+        char         side    = random() % 2 ? 'B' : 'S';
+        Price        offset  = static_cast<Price>(random() % LEVELS) - 3;      // Crossing now and then.
+        Price        price   = side == 'B' ? WORKLOAD_MID - offset : WORKLOAD_MID + offset;
+        OrderRequest request = workload_detail::add(workload.requests, side, 1 + random() % 170, price);
+        request.account      = static_cast<AccountId>(random() % 50 == 0 ? ACCOUNTS : random() % ACCOUNTS);
+        live.push_back(request.id);
+        workload.requests.push_back(request);
+    }
+    return workload;
+}
+
+// Every timed workload above, in the order the benchmarks report them. mixed and risk_limits are for checking only.
+inline vector<Workload> all_workloads(size_t orders, uint64_t seed) {
+    return {deep_queue(orders, seed), sweep(orders, seed), cancel_heavy(orders, seed), random_walk(orders, seed)};
+}
@@ -0,0 +1,102 @@
+/*
+* libFuzzer entry point for the text order parsers.
+*
+* Each input is parsed two ways: in bulk by tokenize_orders (the SIMD/SWAR fast path), and line by line by
+* splitting on the same delimiters and calling parse_order, the reference. The two must agree on every row -
+* side and result always, quantity and price when the row is valid - and on the number of malformed lines.
+* Every valid row must also hold a positive quantity and a price on the tick, and that price must format
+* and parse back to itself. Any difference aborts, which libFuzzer reports with the input that caused it.
+* The first byte of the input picks one of a few tick sizes.
+*
+* Usage:
+*   clang++ -std=c++20 -g -O1 -fsanitize=fuzzer,address,undefined -Iinclude src/price.cpp src/order_parser.cpp
+*       src/order_tokenizer.cpp fuzz/order_parser_fuzz.cpp -o order_parser_fuzz
+*   ./order_parser_fuzz -max_len=4096 corpus/
+*/
+
+#include "order_parser.hpp"
+#include "order_tokenizer.hpp"
+#include "price.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <string_view>
+#include <vector>
+using namespace std;
+
+static const TickSize FUZZ_TICK_SIZES[] = {DEFAULT_TICK_SIZE, TickSize{2, 5}, TickSize{0, 1}, TickSize{6, 250}};
+
+// A row as the reference reads it.
+struct ReferenceRow {
+    char             side;
+    ValidationResult result;
+    ParsedOrder      order;
+};
+
+static bool is_delimiter(char c) {
+    return c == ' ' || c == ',' || c == '\t' || c == '\r';
+}
+
+// Split each line on runs of delimiters and parse lines of three fields with parse_order.
+static void parse_lines(string_view text, const TickSize& tick_size, vector<ReferenceRow>& rows, size_t& malformed) {
+    while (!text.empty()) {
+        size_t      end  = text.find('\n');
+        string_view line = text.substr(0, end);
+        text             = end == string_view::npos ? string_view() : text.substr(end + 1);
+
+        string_view fields[3];
+        size_t      count = 0;
+        for (size_t i = 0; i < line.size();) {
+            if (is_delimiter(line[i])) {
+                i++;
+                continue;
+            }
+            size_t start = i;
+            while (i < line.size() && !is_delimiter(line[i])) i++;
+            if (count < 3) fields[count] = line.substr(start, i - start);
+            count++;
+        }
+        if (count == 0) continue;
+        if (count != 3) {
+            malformed++;
+            continue;
+        }
+
+        ReferenceRow row{fields[0][0], ValidationResult::INVALID_SIDE, ParsedOrder{fields[0][0], 0, 0}};
+        if (fields[0].size() == 1) row.result = parse_order(row.side, fields[1], fields[2], tick_size, row.order);
+        rows.push_back(row);
+    }
+}
+
+static void check(bool condition) {
+    if (!condition) abort();
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    if (size == 0) return 0;
+    const TickSize& tick_size = FUZZ_TICK_SIZES[data[0] % (sizeof(FUZZ_TICK_SIZES) / sizeof(FUZZ_TICK_SIZES[0]))];
+    string_view     text(reinterpret_cast<const char*>(data + 1), size - 1);
+
+    OrderColumns orders;
+    tokenize_orders(text, tick_size, orders);
+
+    vector<ReferenceRow> rows;
+    size_t               malformed = 0;
+    parse_lines(text, tick_size, rows, malformed);
+
+    check(orders.size() == rows.size() && orders.malformed_lines == malformed);
+    for (size_t i = 0; i < rows.size(); i++) {
+        check(orders.sides[i] == rows[i].side && orders.results[i] == rows[i].result);
+        if (rows[i].result != ValidationResult::VALID) continue;
+
+        Quantity quantity = orders.quantities[i];
+        Price    price    = orders.prices[i];
+        check(quantity == rows[i].order.quantity && price == rows[i].order.price);
+        check(quantity > 0 && price >= tick_size.units && price % tick_size.units == 0);
+
+        ParsedOrder again;
+        check(parse_order(rows[i].side, "1", format_price(price, tick_size), tick_size, again) == ValidationResult::VALID &&
+              again.price == price);
+    }
+    return 0;
+}
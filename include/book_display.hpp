@@ -0,0 +1,52 @@
+/*
+* Layout shared by the print_order_book of every engine, so they all render the book identically.
+*
+* A BookRenderer builds a whole frame - header and one row per level pair - in a char buffer it keeps
+* between frames, formats quantities and prices with to_chars (format_price_to), and hands the frame
+* to the stream in a single write. Once the buffer has grown to the size of a frame, rendering does
+* not allocate.
+*
+* Usage:
+*   BookRenderer renderer;
+*   renderer.begin();
+*   renderer.add_row(&bid, nullptr, tick_size);      // A bid level with no ask level beside it
+*   renderer.write(cout);
+*/
+
+#pragma once
+
+#include "depth_cache.hpp"
+#include "price.hpp"
+#include <cstddef>
+#include <iostream>
+#include <string>
+using namespace std;
+
+// Used to display Order book columns - BUY and SELL
+const size_t COLUMN_WIDTH      = 15; 
+const string ORDER_BOOK_HEADER = "BUY            |           SELL"; 
+
+// Bytes a renderer reserves up front - a frame of about 300 rows.
+const size_t RENDER_BUFFER_SIZE = 1 << 14;
+
+class BookRenderer {
+public:
+    BookRenderer() { frame.reserve(RENDER_BUFFER_SIZE); }
+
+    // Start a new frame with the header, dropping the previous frame but keeping its buffer.
+    void begin();
+
+    // Append a row: a bid cell, left-aligned, and an ask cell, right-aligned. A null level leaves its cell blank.
+    void add_row(const DepthLevel* bid, const DepthLevel* ask, const TickSize& tick_size);
+
+    // End the frame and write it to out in one go, then flush.
+    void write(ostream& out);
+
+    // Bytes of the frame buffer.
+    size_t capacity() const { return frame.capacity(); }
+
+private:
+    string frame;
+
+    void add_cell(const DepthLevel* level, const TickSize& tick_size, bool align_right);
+};
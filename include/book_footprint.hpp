@@ -0,0 +1,34 @@
+/*
+* Memory footprint of an order book, as reported by footprint(), and how much of it is in use.
+*
+* The storage of a book grows with the most orders and levels it ever held at once and, on its own, never
+* shrinks: the order pool keeps its chunks, the level arena its node blocks and the order index its table.
+* compact() gives back what the book no longer needs (see OrderBook::compact).
+*
+* Usage:
+*   BookFootprint footprint = order_book.footprint();
+*   if (footprint.total_bytes() > 2 * footprint.bytes_in_use()) order_book.compact();
+*/
+
+#pragma once
+
+#include <cstddef>
+using namespace std;
+
+struct BookFootprint {
+    size_t levels              = 0; // Price levels, both sides.
+    size_t level_bytes         = 0; // Level arena: map nodes, in use or free.
+    size_t level_bytes_in_use  = 0;
+    size_t orders              = 0; // Resting orders.
+    size_t order_pool_capacity = 0; // Order nodes, in use or free.
+    size_t order_pool_bytes    = 0; // Both halves (OrderNode and OrderInfo) of every node.
+    size_t order_bytes_in_use  = 0;
+    size_t index_slots         = 0; // Slots of the order id index, at most half of them full.
+    size_t index_bytes         = 0;
+    size_t fixed_bytes         = 0; // The book object itself (depth cache included) and its render buffer.
+
+    size_t total_bytes() const { return level_bytes + order_pool_bytes + index_bytes + fixed_bytes; }
+
+    // What the book would need with no free nodes and an index table at most half full.
+    size_t bytes_in_use() const { return level_bytes_in_use + order_bytes_in_use + index_bytes + fixed_bytes; }
+};
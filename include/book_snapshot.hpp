@@ -0,0 +1,99 @@
+/*
+* Compact snapshots of the resting orders of a book, for restarting without replaying the whole day.
+*
+* A snapshot file is a SnapshotHeader followed by the book's resting orders as OrderRecords, in the order
+* export_orders writes them: each side in price order, each level in time priority. Loading maps the
+* file and bulk-loads the records with restore(), which links them straight into their levels - no
+* matching, no events, no tree search per order. The header records the last journal sequence number
+* reflected in the snapshot, so only the journal records after it need replaying (see journal.hpp).
+*
+* Usage:
+*   save_snapshot(order_book, "book.snapshot", journal.last_sequence());
+*
+*   uint64_t sequence = 0;                           // After a restart
+*   load_snapshot(order_book, "book.snapshot", sequence);
+*   replay_journal(order_book, journal_records, sequence);
+*/
+
+#pragma once
+
+#include "mapped_file.hpp"
+#include "order_pool.hpp"
+#include "order_record.hpp"
+#include "price.hpp"
+#include <cstdint>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <vector>
+using namespace std;
+
+const uint64_t SNAPSHOT_MAGIC   = 0x31504e53'4b4f4f42; // "BOOKSNP1" read as little-endian bytes.
+const uint32_t SNAPSHOT_VERSION = 1;
+
+struct SnapshotHeader {
+    uint64_t magic;
+    uint32_t version;
+    int32_t  tick_decimals;    // Tick size of the book the orders were taken from.
+    Price    tick_units;
+    OrderId  next_order_id;
+    uint64_t journal_sequence; // Last journal record reflected in the snapshot, 0 if none.
+    uint64_t order_count;      // OrderRecords that follow the header.
+};
+
+static_assert(sizeof(SnapshotHeader) == 48 && is_trivially_copyable_v<SnapshotHeader>, "SnapshotHeader is a wire format");
+
+/*
+* @brief
+* Write a snapshot file. The file is written under a temporary name, synced and then renamed over path,
+* so a crash leaves either the old snapshot or the new one, never a partial file.
+*
+* @return: false if the file could not be written (errno says why).
+*/
+bool write_snapshot(const string& path, const SnapshotHeader& header, span<const OrderRecord> orders);
+
+class MappedSnapshot : public MappedFile {
+    /*
+    * A mapped snapshot file.
+    */
+
+public:
+    // The header, or nullptr if the file is not a complete snapshot of this version.
+    const SnapshotHeader* header() const;
+
+    // The resting orders; empty if header() is nullptr.
+    span<const OrderRecord> orders() const;
+};
+
+/*
+* @brief Snapshot the resting orders of a book.
+* @param journal_sequence: Last journal record already applied to the book.
+* @return: false if the file could not be written.
+*/
+template <class Book>
+bool save_snapshot(const Book& order_book, const string& path, uint64_t journal_sequence) {
+    vector<OrderRecord> orders;
+    order_book.export_orders(orders);
+    TickSize tick = order_book.tick();
+    SnapshotHeader header{SNAPSHOT_MAGIC, SNAPSHOT_VERSION, tick.decimals, tick.units,
+                          order_book.next_id(), journal_sequence, orders.size()};
+    return write_snapshot(path, header, orders);
+}
+
+/*
+* @brief Bulk-load a snapshot into an empty book with the same tick size.
+* @param journal_sequence: Set to the last journal record reflected in the snapshot.
+* @return: false, with the book left unchanged, if the file is missing, not a valid snapshot or not for this book.
+*/
+template <class Book>
+bool load_snapshot(Book& order_book, const string& path, uint64_t& journal_sequence) {
+    MappedSnapshot file;
+    if (!file.open(path) || file.header() == nullptr) return false;
+
+    const SnapshotHeader& header = *file.header();
+    TickSize tick = order_book.tick();
+    if (header.tick_decimals != tick.decimals || header.tick_units != tick.units) return false;
+    if (!order_book.restore(file.orders(), header.next_order_id)) return false;
+    journal_sequence = header.journal_sequence;
+    return true;
+}
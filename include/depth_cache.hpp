@@ -0,0 +1,91 @@
+/*
+* Top-of-book and depth-N snapshots, kept incrementally by the order books.
+*
+* A DepthCache holds the best MAX_DEPTH levels of each side as plain arrays. The book passes it every
+* change to a level's total volume, and the cache patches itself in place: a quantity change or a new
+* level inside the top N is an update of at most MAX_DEPTH entries. Only when a level leaves a full
+* top N - so the next level in line is unknown to the cache - is that side marked dirty, and the book
+* refills it from its first MAX_DEPTH levels on the next snapshot. No snapshot walks the whole book.
+*
+* Usage:
+*   DepthSnapshot snapshot = order_book.depth(5);
+*   for (uint32_t i = 0; i < snapshot.bid_levels; i++)
+*       publish(snapshot.bids[i].price, snapshot.bids[i].quantity);
+*/
+
+#pragma once
+
+#include "price.hpp"
+#include <cstddef>
+#include <cstdint>
+using namespace std;
+
+// Levels per side kept by the cache and returned by the largest snapshot.
+const size_t MAX_DEPTH = 10;
+
+// Price and total volume of one level.
+struct DepthLevel {
+    Price    price;
+    Quantity quantity;
+};
+
+// Best bid and best ask. The quantity of a side with no orders is 0.
+struct TopOfBook {
+    DepthLevel bid;
+    DepthLevel ask;
+};
+
+// The best levels of each side, best first.
+struct DepthSnapshot {
+    DepthLevel bids[MAX_DEPTH];
+    DepthLevel asks[MAX_DEPTH];
+    uint32_t   bid_levels;
+    uint32_t   ask_levels;
+};
+
+class DepthCache {
+public:
+    struct Side {
+        DepthLevel levels[MAX_DEPTH];
+        uint32_t   count = 0;
+        bool       dirty = false; // Levels beyond the cached ones may now belong in the top N.
+
+        // Clear before a refill from the book.
+        void reset() { count = 0; dirty = false; }
+
+        // Append during a refill, best level first.
+        void push_back(Price price, Quantity quantity) { levels[count++] = DepthLevel{price, quantity}; }
+
+        bool full() const { return count == MAX_DEPTH; }
+    };
+
+    Side bids;
+    Side asks;
+
+    // Record the new total volume of a level; 0 means the level is gone.
+    void update(char side, Price price, Quantity total_volume) {
+        Side& cached  = side == 'B' ? bids : asks;
+        if (cached.dirty) return; // Will be refilled anyway.
+        bool is_bid   = side == 'B';
+
+        // Find the level, or the position it would take, among the cached levels.
+        uint32_t i = 0;
+        while (i < cached.count && (is_bid ? cached.levels[i].price > price : cached.levels[i].price < price)) i++;
+
+        bool found = i < cached.count && cached.levels[i].price == price;
+        if (found && total_volume > 0) {
+            cached.levels[i].quantity = total_volume;
+        } else if (found) {
+            // A level left the top N. If the cache was full, the level that now moves up is unknown.
+            bool was_full = cached.full();
+            for (uint32_t j = i; j + 1 < cached.count; j++) cached.levels[j] = cached.levels[j + 1];
+            cached.count--;
+            cached.dirty = was_full;
+        } else if (total_volume > 0 && i < MAX_DEPTH) {
+            // A new level inside the top N pushes the worst cached level out if the cache is full.
+            uint32_t last = cached.full() ? cached.count - 1 : cached.count++;
+            for (uint32_t j = last; j > i; j--) cached.levels[j] = cached.levels[j - 1];
+            cached.levels[i] = DepthLevel{price, total_volume};
+        }
+    }
+};
@@ -0,0 +1,132 @@
+/*
+* Book events carried across threads.
+*
+* An EventQueueSink is the sink of a book that runs on a matching thread of its own: instead of
+* handling events, it copies each one into an SpscQueue as a BookEvent. Another thread pops them and
+* hands them to the sink that does the real work (printing, publishing) with dispatch_event, so the
+* matcher never waits on output - only on a full queue.
+*
+* Usage:
+*   SpscQueue<BookEvent> events(65536);
+*   EventQueueSink queue_sink(events);              // Matching thread: OrderBook order_book(tick, &queue_sink)
+*   BookEvent event;
+*   do events.pop(event);                           // Output thread
+*   while (dispatch_event(event, printing_sink));
+*/
+
+#pragma once
+
+#include "event_sink.hpp"
+#include "spsc_queue.hpp"
+using namespace std;
+
+enum class EventType : char {
+    TRADE,
+    ADD,
+    CANCEL,
+    MODIFY,
+    REJECT,
+    BOOK_UPDATE,
+    FLUSH,
+    CLOSE     // No more events will follow.
+};
+
+// Any one event of a book, tagged with its type.
+struct BookEvent {
+    EventType type;
+    union {
+        TradeEvent      trade;
+        AddEvent        add;
+        CancelEvent     cancel;
+        ModifyEvent     modify;
+        RejectEvent     reject;
+        BookUpdateEvent book_update;
+    };
+};
+
+template <class WaitPolicy = SpinWait>
+class EventQueueSink : public EventSink {
+    /*
+    * Pushes every event into a queue, waiting according to the queue's WaitPolicy while it is full.
+    * Must be used from a single thread, the queue's producer.
+    */
+
+private:
+    SpscQueue<BookEvent, WaitPolicy>& queue;
+
+    void push(EventType type) {
+        BookEvent event;
+        event.type = type;
+        queue.push(event);
+    }
+
+public:
+    explicit EventQueueSink(SpscQueue<BookEvent, WaitPolicy>& queue) : queue(queue) {}
+
+    void on_trade(const TradeEvent& trade) override {
+        BookEvent event;
+        event.type  = EventType::TRADE;
+        event.trade = trade;
+        queue.push(event);
+    }
+
+    void on_add(const AddEvent& add) override {
+        BookEvent event;
+        event.type = EventType::ADD;
+        event.add  = add;
+        queue.push(event);
+    }
+
+    void on_cancel(const CancelEvent& cancel) override {
+        BookEvent event;
+        event.type   = EventType::CANCEL;
+        event.cancel = cancel;
+        queue.push(event);
+    }
+
+    void on_modify(const ModifyEvent& modify) override {
+        BookEvent event;
+        event.type   = EventType::MODIFY;
+        event.modify = modify;
+        queue.push(event);
+    }
+
+    void on_reject(const RejectEvent& reject) override {
+        BookEvent event;
+        event.type   = EventType::REJECT;
+        event.reject = reject;
+        queue.push(event);
+    }
+
+    void on_book_update(const BookUpdateEvent& book_update) override {
+        BookEvent event;
+        event.type        = EventType::BOOK_UPDATE;
+        event.book_update = book_update;
+        queue.push(event);
+    }
+
+    void flush() override { push(EventType::FLUSH); }
+
+    // Tell the consumer that the book is done.
+    void close() { push(EventType::CLOSE); }
+};
+
+/*
+* @brief Hand an event popped from an EventQueueSink's queue to a sink.
+* @param event: The event.
+* @param sink: Sink to call.
+* @return: False for the CLOSE event, which ends the stream.
+*/
+inline bool dispatch_event(const BookEvent& event, EventSink& sink) {
+    switch (event.type) {
+        case EventType::TRADE:       sink.on_trade(event.trade);             break;
+        case EventType::ADD:         sink.on_add(event.add);                 break;
+        case EventType::CANCEL:      sink.on_cancel(event.cancel);           break;
+        case EventType::MODIFY:      sink.on_modify(event.modify);           break;
+        case EventType::REJECT:      sink.on_reject(event.reject);           break;
+        case EventType::BOOK_UPDATE: sink.on_book_update(event.book_update); break;
+        case EventType::FLUSH:       sink.flush();                           break;
+        case EventType::CLOSE:       return false;
+    }
+    return true;
+}
@@ -0,0 +1,169 @@
+/*
+* Typed events published by the order books, and the sinks that consume them.
+*
+* The books never format or print anything themselves. Every trade, accepted order, cancel, amend,
+* rejection and change to the aggregate volume of a level is handed to an EventSink as a small struct
+* with integer prices. Printing is just one sink (PrintingSink); NullSink drops everything, which
+* measures the matcher alone.
+*
+* Usage:
+*   NullSink sink;
+*   OrderBook order_book(DEFAULT_TICK_SIZE, &sink);
+*/
+
+#pragma once
+
+#include "order_parser.hpp"
+#include "order_pool.hpp"
+#include "price.hpp"
+#include <cstdint>
+#include <iostream>
+using namespace std;
+
+// A fill between a resting (maker) order and the order that arrived later (taker), at the maker's price.
+struct TradeEvent {
+    OrderId  maker_id;
+    OrderId  taker_id;
+    char     taker_side;
+    Price    price;
+    Quantity quantity;
+};
+
+// An order, or what is left of it after matching, resting in the book.
+struct AddEvent {
+    OrderId  id;
+    char     side;
+    Price    price;
+    Quantity quantity;
+    uint64_t sequence; // Book-assigned priority within the level: lower is ahead.
+};
+
+// Why a resting order was cancelled or had its quantity changed.
+enum class AmendReason : uint8_t {
+    REQUEST,    // A cancel_order or modify_order of the order's owner.
+    SELF_TRADE  // The book's self-trade prevention, when an order of the same account arrived (see match_policy.hpp).
+};
+
+// A resting order removed by cancel_order or by self-trade prevention, with the quantity it still had.
+struct CancelEvent {
+    OrderId     id;
+    char        side;
+    Price       price;
+    Quantity    quantity;
+    AmendReason reason;
+};
+
+// A resting order whose remaining quantity was changed by modify_order or reduced by self-trade prevention.
+struct ModifyEvent {
+    OrderId     id;
+    char        side;
+    Price       price;
+    Quantity    quantity;
+    uint64_t    sequence; // Priority after the change - a new, higher one if the quantity went up.
+    AmendReason reason;
+};
+
+// An order refused by add_order, or a modify refused by the risk checks.
+struct RejectEvent {
+    ValidationResult reason;
+};
+
+// New total volume of a price level. A total of 0 means the level is gone.
+struct BookUpdateEvent {
+    char     side;
+    Price    price;
+    Quantity total_volume;
+};
+
+class EventSink {
+    /*
+    * Receives the events of an order book, in the order they happen. All handlers default to doing
+    * nothing, so a sink only overrides what it cares about.
+    */
+
+public:
+    virtual ~EventSink() = default;
+
+    virtual void on_trade(const TradeEvent&)            {}
+    virtual void on_add(const AddEvent&)                {}
+    virtual void on_cancel(const CancelEvent&)          {}
+    virtual void on_modify(const ModifyEvent&)          {}
+    virtual void on_reject(const RejectEvent&)          {}
+    virtual void on_book_update(const BookUpdateEvent&) {}
+
+    // End of the events of one accepted add, cancel or modify - the point to flush any buffered output.
+    virtual void flush() {}
+};
+
+// Drops every event.
+class NullSink : public EventSink {};
+
+class TeeSink : public EventSink {
+    /*
+    * Hands every event to two sinks, first then second - e.g. to print trades and publish market data.
+    */
+
+private:
+    EventSink& first;
+    EventSink& second;
+
+public:
+    TeeSink(EventSink& first, EventSink& second) : first(first), second(second) {}
+
+    void on_trade(const TradeEvent& trade) override                { first.on_trade(trade);        second.on_trade(trade); }
+    void on_add(const AddEvent& add) override                      { first.on_add(add);            second.on_add(add); }
+    void on_cancel(const CancelEvent& cancel) override             { first.on_cancel(cancel);      second.on_cancel(cancel); }
+    void on_modify(const ModifyEvent& modify) override             { first.on_modify(modify);      second.on_modify(modify); }
+    void on_reject(const RejectEvent& reject) override             { first.on_reject(reject);      second.on_reject(reject); }
+    void on_book_update(const BookUpdateEvent& update) override    { first.on_book_update(update); second.on_book_update(update); }
+    void flush() override                                          { first.flush();                second.flush(); }
+};
+
+class PrintingSink : public EventSink {
+    /*
+    * Prints trades and rejections the way the interactive script shows them:
+    * one "<quantity>@<price>" line per trade, and "ERROR: <reason>" for a rejected order.
+    */
+
+private:
+    TickSize tick_size;
+    ostream& out;
+
+public:
+    explicit PrintingSink(TickSize tick_size = DEFAULT_TICK_SIZE, ostream& out = cout) : tick_size(tick_size), out(out) {}
+
+    void on_trade(const TradeEvent& trade) override;
+    void on_reject(const RejectEvent& reject) override;
+    void flush() override;
+};
+
+class ChecksumSink : public EventSink {
+    /*
+    * Folds every event, field by field, into a 64-bit FNV-1a checksum, and counts trades and rejections.
+    * Two runs that publish the same events in the same order - flushes included - have the same checksum
+    * on any machine, so a replay can be checked against another one by comparing a single number.
+    */
+
+private:
+    uint64_t hash         = 0xcbf29ce484222325; // FNV-1a offset basis.
+    uint64_t trade_count  = 0;
+    Quantity volume       = 0;
+    uint64_t reject_count = 0;
+
+    // Fold one value in, as 8 bytes least significant first.
+    void mix(uint64_t value);
+
+public:
+    void on_trade(const TradeEvent& trade) override;
+    void on_add(const AddEvent& add) override;
+    void on_cancel(const CancelEvent& cancel) override;
+    void on_modify(const ModifyEvent& modify) override;
+    void on_reject(const RejectEvent& reject) override;
+    void on_book_update(const BookUpdateEvent& update) override;
+    void flush() override;
+
+    uint64_t checksum() const { return hash; }
+    uint64_t trades() const { return trade_count; }
+    Quantity traded_volume() const { return volume; }
+    uint64_t rejects() const { return reject_count; }
+};
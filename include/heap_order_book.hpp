@@ -0,0 +1,311 @@
+/*
+* Defines HeapOrderBook, the alternate OrderBook built on a priority_queue and a set which share
+* pointers to HeapOrder objects.
+*
+* Notes:
+*   - Prices are floats truncated to PRECISION, and trades are matched in a separate pass after each add.
+*   - Kept for comparison with OrderBook (see bench/order_book_bench.cpp); it supports neither
+*     cancels nor amends.
+*
+* Usage:
+*   HeapOrderBook order_book;                 // Prints to cout, or HeapOrderBook order_book(out);
+*   order_book.add_order('B', "50", "10.39", 1);
+*   order_book.execute_and_print_trades();
+*   order_book.print_order_book();
+*/
+
+#pragma once
+
+#include "book_display.hpp"
+#include "price.hpp"
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <queue>
+#include <regex>
+#include <set>
+#include <string>
+#include <vector>
+using namespace std;
+
+const float PRECISION = 0.001f; // Ignoring anything after 3 decimal places in stock price
+
+// A float price, already truncated to PRECISION, in units of DEFAULT_TICK_SIZE for format_price.
+inline Price heap_price_units(float price) {
+    return static_cast<Price>(lround(price / PRECISION));
+}
+
+
+struct HeapOrder {
+    char side;
+    int quantity;
+    float price;
+    int timestamp;
+};
+
+// Prices are truncated to PRECISION, so two of them are the same price when they are within half a tick. A whole
+// tick is too wide: float rounding puts adjacent ticks such as 10.008 and 10.009 a little under PRECISION apart.
+inline bool same_heap_price(float a, float b) {
+    return abs(a - b) < PRECISION / 2;
+}
+
+// Higher bid followed by earlier bid => more priority
+struct CompareBuyOrders {
+    bool operator()(const HeapOrder* a, const HeapOrder* b) const {
+        if (same_heap_price(a->price, b->price)) 
+            return a->timestamp > b->timestamp;
+        return a->price < b->price;
+    }
+};
+
+// Lower ask followed by earlier ask => more priority
+struct CompareSellOrders {
+    bool operator()(const HeapOrder* a, const HeapOrder* b) const {
+        if (same_heap_price(a->price, b->price)) 
+            return a->timestamp > b->timestamp;
+        return a->price > b->price;
+    }
+};
+
+class HeapOrderPool {
+    /*
+    * Hands out HeapOrder objects from chunks of CHUNK_SIZE and recycles released ones, instead of a
+    * new/delete per order. Orders never move, so the pointers shared by the queue and set stay valid.
+    */
+
+private:
+    static const size_t CHUNK_SIZE = 4096;
+
+    vector<unique_ptr<HeapOrder[]>> chunks;
+    vector<HeapOrder*> free_orders;
+    size_t in_use     = 0;
+    size_t high_water = 0;
+
+public:
+    HeapOrder* allocate(const HeapOrder& order) {
+        if (free_orders.empty()) {
+            chunks.emplace_back(make_unique<HeapOrder[]>(CHUNK_SIZE));
+            for (size_t i = CHUNK_SIZE; i-- > 0;) free_orders.push_back(&chunks.back()[i]);
+        }
+        HeapOrder* slot = free_orders.back();
+        free_orders.pop_back();
+        *slot = order;
+
+        high_water = max(high_water, ++in_use);
+        return slot;
+    }
+
+    void release(HeapOrder* order) {
+        free_orders.push_back(order);
+        in_use--;
+    }
+
+    // Most orders alive at the same time.
+    size_t high_water_mark() const { return high_water; }
+};
+
+class HeapOrderBook {
+    /*
+    * Maintains an Exchange Order Book and provides the following functionalities:
+    * - Add a new order (side, quantity, price, timestamp)
+    * - Execute trades by matching the orders (and also print them)
+    * - Print Order Book status
+    *
+    * Data structures used:
+    * - Max-heap (priority_queue) for frequent retreival of best prices and popping out  
+    *   orders once they are executed completely. 
+    * - Balanced-binary-tree (set) for book-keeping - to efficiently display unmatched
+    *   orders, in price-priority (no time-priority since we aggregate orders across time, by price).
+    *
+    * TODO: 
+    * Explore whether an ordered map instead of an ordered set can be more effective. 
+    * The map can have independent Order objects that are keyed by price, quantities 
+    * aggregated over orders submitted at the same price. This can make us do away 
+    * with pointers, since there are no shared references between the queue and map.
+    * The overhead will be more updates to Order objects in the map, now that they are
+    * independent from the objects in priority queue. 
+    */
+
+private:
+    // Orders are maintained in a max-heap in price-time-priority - Bids and Asks separately.
+    priority_queue<HeapOrder*, vector<HeapOrder*>, CompareBuyOrders>  buy_order_queue;
+    priority_queue<HeapOrder*, vector<HeapOrder*>, CompareSellOrders> sell_order_queue;
+
+    // Orders are also maintained in a balanced-binary-tree for book-keeping - Bids and Asks separately.
+    set<HeapOrder*, CompareBuyOrders>  buy_order_set;
+    set<HeapOrder*, CompareSellOrders> sell_order_set;
+
+    // Storage of the orders the queues and sets point to.
+    HeapOrderPool order_pool;
+
+    // Where trades, errors and the book are printed.
+    ostream& out;
+
+    template <class Itr>
+    pair<string, Itr> get_next_entry(Itr it, Itr it_end, bool align) {
+        /*
+        * Utility function used to get the total quantity of order for a given price.
+        * The "given price" part is inferred from the corresponding order book's 
+        * iterator that is passed. We increment the iterator till we see all 
+        * unmatched orders in the given price, and aggregate the quantities.  
+        */
+
+        int cum_order_size     = (*it)->quantity;
+        float last_order_price = (*it)->price;
+        while (++it != it_end && (*it)->price == last_order_price)
+            cum_order_size += (*it)->quantity;
+        
+        string cell = to_string(cum_order_size) + "@" + format_price(heap_price_units(last_order_price), DEFAULT_TICK_SIZE);
+        size_t pad  = COLUMN_WIDTH - cell.size();
+        align ? cell.insert(0, pad, ' ') : cell.append(pad, ' ');
+
+        return {cell, it};
+    }
+
+    enum class ValidationResult {
+        /* The four horsemen of invalid input */
+        VALID,
+        INVALID_SIDE,
+        INVALID_QUANTITY,
+        INVALID_PRICE
+    };
+
+    ValidationResult validate_inputs(char side, string quantity, string price) {
+        /*
+        Returns the result of input validation.
+        If there are several invalidities in the input, the first of them is reported.
+        */
+        if (side != 'B' && side != 'S')
+            return ValidationResult::INVALID_SIDE;
+        if (!regex_match(quantity, std::regex("^[1-9][0-9]*$")))
+            return ValidationResult::INVALID_QUANTITY;
+        if (!regex_match(price, std::regex("^[0-9]*\\.?[0-9]+$")) || stof(price) < PRECISION)
+            return ValidationResult::INVALID_PRICE;
+        return ValidationResult::VALID;
+    }
+
+    string input_validation_message(ValidationResult result) {
+        /*
+        Returns a human-readable message corresponding to the validation result.
+        */
+        switch (result) {
+            case ValidationResult::VALID:
+                return "Good";
+            case ValidationResult::INVALID_SIDE:
+                return "Side should be either \'B\' or \'S\'";
+            case ValidationResult::INVALID_QUANTITY:
+                return "Order quantity should be a positive integer";
+            case ValidationResult::INVALID_PRICE:
+                return "Price should be a positive value >= tick size (" +
+                       format_price(heap_price_units(PRECISION), DEFAULT_TICK_SIZE) + ")";
+        }
+        return "Unknown validation result";
+    }
+
+public:
+    explicit HeapOrderBook(ostream& out = cout) : out(out) {}
+
+    bool add_order(char side, string quantity_str, string price_str, int timestamp) {
+        /*
+        * Create a new Order (buy or sell based on "side") object with the given
+        * price, quantity and timestamp. Timestamp is used to to determine 
+        * price-time-priority when matching buy and sell orders.
+        * It is also used to determine the price at which a trade should be executed, 
+        * based on whether the buy or sell order came first.
+        */
+
+        // Validate inputs and create a new Order.
+        ValidationResult validation_result = validate_inputs(side, quantity_str, price_str);
+        if (validation_result != ValidationResult::VALID) {
+            out << "ERROR: " << input_validation_message(validation_result) << endl;
+            return false;
+        }
+
+        // Truncate price to 3 decimal places (PRECISION sets this behaviour)
+        float price      = stof(price_str);
+        int scale_factor = ceil(1 / PRECISION);
+        long scaled      = static_cast<long> (price * scale_factor);
+        price            = static_cast<double>(scaled) / scale_factor;
+
+        add_order(side, stoi(quantity_str), price, timestamp);
+        return true;
+    }
+
+    void add_order(char side, int quantity, float price, int timestamp) {
+        /*
+        * Same as above for an order that is already validated and truncated to PRECISION, e.g. one
+        * generated by a benchmark. Timestamps must be unique, they order the queues and sets.
+        */
+
+        HeapOrder* order = order_pool.allocate(HeapOrder{side, quantity, price, timestamp});
+
+        // Add new order to the appropriate order queue and set 
+        side == 'B' ? buy_order_queue.push(order) : sell_order_queue.push(order);
+        side == 'B' ? buy_order_set.insert(order) : sell_order_set.insert(order);
+    }
+
+    void execute_and_print_trades() {
+        /*
+        * Start by matching the most enticing buy order with the most enticing sell order.
+        * Keep doing the above until the maximum bid is less than the minimum ask. 
+        */
+
+        while(!(buy_order_queue.empty() || sell_order_queue.empty())) {
+            HeapOrder* best_buy_order  = buy_order_queue.top();
+            HeapOrder* best_sell_order = sell_order_queue.top();
+            if (best_buy_order->price < best_sell_order->price) break;
+
+            int   trade_quantity = min(best_buy_order->quantity, best_sell_order->quantity);
+            float trade_price    = best_buy_order->timestamp > best_sell_order->timestamp ? 
+                                   best_sell_order->price : best_buy_order->price;
+
+            // Print the trade that is to be executed                 
+            out << trade_quantity << "@" << trade_price << endl;
+
+            // Update order quantities as per executed trade
+            best_buy_order->quantity  -= trade_quantity;
+            best_sell_order->quantity -= trade_quantity;
+
+            // Remove orders that are completely matched
+            auto remove_empty_order = [&](auto*& order, auto& order_queue, auto& order_set) {
+                order_queue.pop();
+                order_set.erase(order);
+                order_pool.release(order);
+                if (!order_queue.empty()) order = order_queue.top();
+            };
+
+            if (best_buy_order->quantity == 0)  remove_empty_order(best_buy_order, buy_order_queue, buy_order_set);
+            if (best_sell_order->quantity == 0) remove_empty_order(best_sell_order, sell_order_queue, sell_order_set);
+        }
+    }
+
+    void print_order_book() {
+        /* 
+        * Print the current state of the order book i.e only the unmatched orders.
+        * We group orders by price and display them in price-priority: highest bid and lowest ask.
+        */
+
+        out << ORDER_BOOK_HEADER << endl;
+        
+        auto itB = buy_order_set.rbegin(),  itBend = buy_order_set.rend();
+        auto itS = sell_order_set.rbegin(), itSend = sell_order_set.rend();
+
+        while (itB != itBend || itS != itSend) {
+            string row = "";
+
+            auto append_cell = [&](auto& it, auto end, bool align) {
+                if (it == end) return string(COLUMN_WIDTH, ' ');
+                auto [cell, next] = get_next_entry(it, end, align);
+                it = next;
+                return cell;
+            };
+            
+            row += append_cell(itB, itBend, 0);
+            row += '|';
+            row += append_cell(itS, itSend, 1);
+            out << row << endl;
+        }
+    }
+};
+
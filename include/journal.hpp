@@ -0,0 +1,164 @@
+/*
+* Append-only journal of the requests a book accepted, for rebuilding the book after a restart.
+*
+* Every add, cancel and modify that succeeded is appended as a fixed-width JournalRecord with a sequence
+* number, adds with the id the book gave them. Replaying the records in order into an empty book - or one
+* restored from a snapshot taken at some sequence number (see book_snapshot.hpp), replaying only what
+* came later - rebuilds exactly the same book, since rejected requests never changed it.
+*
+* Notes:
+*   - Records are buffered and written with one write() per group; commit() writes what is buffered and
+*     fdatasyncs, so a group of records costs one sync (group commit). Records are durable once the
+*     commit() that wrote them returned true. A torn record at the end of the file is dropped on open.
+*   - The file is in the byte order of the machine that wrote it, with no header.
+*
+* Usage:
+*   Journal journal;
+*   journal.open("book.journal");
+*   submit_journaled(order_book, journal, OrderRequest::add('B', 50, 10390, 1730764173));
+*   journal.commit();
+*
+*   MappedJournal records;                          // After a restart
+*   records.open("book.journal");
+*   replay_journal(order_book, records.records());
+*/
+
+#pragma once
+
+#include "mapped_file.hpp"
+#include "order_pool.hpp"
+#include "order_request.hpp"
+#include "price.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <vector>
+using namespace std;
+
+// Records appended between two automatic commits.
+const size_t JOURNAL_GROUP_COMMIT = 4096;
+
+struct JournalRecord {
+    uint64_t    sequence;  // 1, 2, 3, ... in the order the requests were applied.
+    OrderId     id;        // The order added (with the id the book gave it), cancelled or modified.
+    Quantity    quantity;
+    Price       price;
+    int64_t     timestamp;
+    RequestType type;
+    char        side;
+    OrderType   order_type;
+    char        padding;
+    AccountId   account;
+
+    OrderRequest request() const { return OrderRequest{type, side, order_type, account, quantity, price, timestamp, id}; }
+};
+
+static_assert(sizeof(JournalRecord) == 48 && is_trivially_copyable_v<JournalRecord>, "JournalRecord is a wire format");
+
+class Journal {
+    /*
+    * Appends JournalRecords to a file. Non-copyable; the destructor commits and closes.
+    */
+
+private:
+    int                   fd = -1;
+    size_t                group_commit;
+    uint64_t              next_sequence = 1;
+    vector<JournalRecord> buffer;          // Appended, not yet written.
+
+public:
+    /*
+    * @param group_commit: Records appended before append() commits by itself.
+    */
+    explicit Journal(size_t group_commit = JOURNAL_GROUP_COMMIT);
+    ~Journal() { close(); }
+
+    Journal(const Journal&)            = delete;
+    Journal& operator=(const Journal&) = delete;
+
+    /*
+    * @brief
+    * Open a journal for appending, creating it if needed. Sequence numbers continue after the last
+    * complete record already in the file.
+    *
+    * @return: false if the file could not be opened (errno says why).
+    */
+    bool open(const string& path);
+
+    /*
+    * @brief
+    * Append an accepted request; for an add, request.id must be the id the book gave the order.
+    *
+    * @return: sequence number of the record.
+    */
+    uint64_t append(const OrderRequest& request);
+
+    /*
+    * @brief
+    * Write the buffered records and sync them to disk.
+    *
+    * @return: false if the write or the sync failed; unwritten records stay buffered.
+    */
+    bool commit();
+
+    // Commit and close the file.
+    void close();
+
+    // Sequence number of the last record appended, 0 if there is none.
+    uint64_t last_sequence() const { return next_sequence - 1; }
+};
+
+class MappedJournal : public MappedFile {
+    /*
+    * A mapped journal viewed as JournalRecords. A trailing partial record is ignored.
+    */
+
+public:
+    span<const JournalRecord> records() const {
+        return {reinterpret_cast<const JournalRecord*>(bytes().data()), bytes().size() / sizeof(JournalRecord)};
+    }
+};
+
+/*
+* @brief Apply a request to a book and journal it if it succeeded.
+* @return: what order_book.submit(request) returned.
+*/
+template <class Book>
+OrderId submit_journaled(Book& order_book, Journal& journal, OrderRequest request) {
+    OrderId id = order_book.submit(request);
+    if (id != INVALID_ORDER_ID) {
+        request.id = id;
+        journal.append(request);
+    }
+    return id;
+}
+
+/*
+* @brief
+* Apply the journaled requests that come after a sequence number to a book, in bursts through add_orders.
+*
+* @param order_book:     Book to rebuild: empty, or restored from a snapshot taken at after_sequence.
+* @param records:        The journal.
+* @param after_sequence: Last sequence number already reflected in the book.
+*
+* @return: number of records applied.
+*/
+template <class Book>
+size_t replay_journal(Book& order_book, span<const JournalRecord> records, uint64_t after_sequence = 0) {
+    auto first = partition_point(records.begin(), records.end(),
+                                 [&](const JournalRecord& record) { return record.sequence <= after_sequence; });
+    records = records.subspan(static_cast<size_t>(first - records.begin()));
+
+    vector<OrderRequest> burst;
+    burst.reserve(min(records.size(), JOURNAL_GROUP_COMMIT));
+    for (size_t start = 0; start < records.size(); start += JOURNAL_GROUP_COMMIT) {
+        burst.clear();
+        for (const JournalRecord& record : records.subspan(start, min(JOURNAL_GROUP_COMMIT, records.size() - start)))
+            burst.push_back(record.request());
+        order_book.add_orders(burst);
+    }
+    return records.size();
+}
@@ -0,0 +1,106 @@
+/*
+* Hierarchical bitmap over the levels of a bounded price ladder.
+*
+* Bit i of the bottom layer is set when level i holds orders. Every layer above has one bit per
+* 64-bit word of the layer below, set when that word is non-zero, up to a single top word.
+* Finding the first/last set bit, or the next one in either direction, therefore costs one word
+* scan per layer - 3 layers already cover 262144 levels - instead of a walk over empty levels.
+*
+* Usage:
+*   LevelBitmap bitmap(1000);
+*   bitmap.set(42);
+*   bitmap.find_last();      // 42
+*   bitmap.find_prev(41);    // LevelBitmap::npos
+*/
+
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+using namespace std;
+
+class LevelBitmap {
+public:
+    static constexpr size_t npos = SIZE_MAX;
+
+    explicit LevelBitmap(size_t size) {
+        // Build layers bottom-up until a single word summarizes everything.
+        do {
+            size = (size + 63) / 64;
+            layers.emplace_back(size, 0);
+        } while (size > 1);
+    }
+
+    bool test(size_t i) const {
+        return layers[0][i >> 6] >> (i & 63) & 1;
+    }
+
+    void set(size_t i) {
+        for (auto& layer : layers) {
+            uint64_t& word = layer[i >> 6];
+            bool was_empty = word == 0;
+            word |= uint64_t(1) << (i & 63);
+            if (!was_empty) return; // Upper layers already know about this word.
+            i >>= 6;
+        }
+    }
+
+    void clear(size_t i) {
+        for (auto& layer : layers) {
+            uint64_t& word = layer[i >> 6];
+            word &= ~(uint64_t(1) << (i & 63));
+            if (word != 0) return; // Word still non-empty, upper layers unchanged.
+            i >>= 6;
+        }
+    }
+
+    size_t find_first() const { return find_next(0); }
+
+    size_t find_last() const { return find_prev(npos - 1); }
+
+    // Index of the first set bit at or after i, npos if none.
+    size_t find_next(size_t i) const { return find_next(0, i); }
+
+    // Index of the last set bit at or before i, npos if none.
+    size_t find_prev(size_t i) const { return find_prev(0, i); }
+
+private:
+    // layers[0] has one bit per level, layers.back() is a single word.
+    vector<vector<uint64_t>> layers;
+
+    size_t find_next(size_t depth, size_t i) const {
+        const auto& layer = layers[depth];
+        size_t w = i >> 6;
+        if (w >= layer.size()) return npos;
+
+        uint64_t word = layer[w] & (~uint64_t(0) << (i & 63));
+        if (word == 0) {
+            // Nothing left in this word - ask the layer above for the next non-empty word.
+            if (depth + 1 == layers.size()) return npos;
+            w = find_next(depth + 1, w + 1);
+            if (w == npos) return npos;
+            word = layer[w];
+        }
+        return (w << 6) | countr_zero(word);
+    }
+
+    size_t find_prev(size_t depth, size_t i) const {
+        const auto& layer = layers[depth];
+        size_t w = i >> 6;
+        if (w >= layer.size()) {
+            w = layer.size() - 1;
+            i = (w << 6) | 63;
+        }
+
+        uint64_t word = layer[w] & (~uint64_t(0) >> (63 - (i & 63)));
+        if (word == 0) {
+            if (depth + 1 == layers.size() || w == 0) return npos;
+            w = find_prev(depth + 1, w - 1);
+            if (w == npos) return npos;
+            word = layer[w];
+        }
+        return (w << 6) | (63 - countl_zero(word));
+    }
+};
@@ -0,0 +1,43 @@
+/*
+* A whole file mapped read-only into memory, for replaying day files without copying them through a stream.
+*
+* Usage:
+*   MappedFile file;
+*   if (!file.open("orders.txt")) ...
+*   string_view text = file.bytes();
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+using namespace std;
+
+class MappedFile {
+    /*
+    * Maps a file read-only. Non-copyable; the mapping is released by close() or the destructor.
+    */
+
+private:
+    void*  data   = nullptr;
+    size_t length = 0;
+
+public:
+    MappedFile() = default;
+    ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile&)            = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /*
+    * @brief
+    * Map a file. An empty file maps to no bytes.
+    *
+    * @return: false if the file could not be opened or mapped (errno says why).
+    */
+    bool open(const string& path);
+    void close();
+
+    string_view bytes() const { return {static_cast<const char*>(data), length}; }
+};
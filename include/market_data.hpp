@@ -0,0 +1,147 @@
+/*
+* Incremental L2 market-data feed: binary level deltas built from the book's own level updates, with
+* periodic snapshots to recover from.
+*
+* L2FeedSink turns the BookUpdateEvents a book emits - exactly where a level's total volume changes -
+* into feed messages. All the level changes between two flushes, i.e. those caused by one accepted add,
+* cancel or modify (or one batch), are coalesced into a single DELTA message: each level appears once,
+* with its final volume, and a level that ended where it started is left out. Every delta gets the next
+* feed sequence number. Every snapshot_interval deltas the sink also writes a SNAPSHOT of all levels,
+* stamped with the sequence of the last delta it reflects.
+*
+* A subscriber keeps an L2Book. It starts unsynced, ignores deltas until a snapshot, and from then on
+* applies each delta whose sequence follows the last one it saw. On a gap it drops its levels and waits
+* for the next snapshot, so joining late or losing messages never needs a full dump per event.
+*
+* The stream is a sequence of messages, each an L2Header followed by level_count L2Levels, in the byte
+* order of the machine that wrote it. The sink starts the stream with an empty snapshot at sequence 0.
+*
+* Usage:
+*   ofstream out("book.feed", ios::binary);
+*   L2FeedSink feed(out);
+*   OrderBook order_book(DEFAULT_TICK_SIZE, &feed);
+*
+*   L2Book view;                                     // Subscriber
+*   L2Header header;
+*   vector<L2Level> levels;
+*   while (read_l2_message(in, header, levels)) view.apply(header, levels);
+*   DepthSnapshot top = view.depth(5);
+*/
+
+#pragma once
+
+#include "depth_cache.hpp"
+#include "event_sink.hpp"
+#include "price.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <span>
+#include <type_traits>
+#include <vector>
+using namespace std;
+
+// Deltas between two snapshots of an L2FeedSink.
+const uint64_t L2_SNAPSHOT_INTERVAL = 1000;
+
+enum class L2MessageType : uint8_t {
+    DELTA,      // Levels that changed since the previous delta.
+    SNAPSHOT    // Every level of the book.
+};
+
+struct L2Header {
+    uint64_t      sequence;    // DELTA: one more than the previous delta. SNAPSHOT: the last delta it reflects.
+    uint32_t      level_count; // L2Levels that follow the header.
+    L2MessageType type;
+    uint8_t       padding[3];
+};
+
+struct L2Level {
+    Price    price;
+    Quantity quantity;         // New total volume of the level; 0 means the level is gone (DELTA only).
+    char     side;             // 'B' or 'S'.
+    char     padding[7];
+};
+
+static_assert(sizeof(L2Header) == 16 && is_trivially_copyable_v<L2Header>, "L2Header is a wire format");
+static_assert(sizeof(L2Level)  == 24 && is_trivially_copyable_v<L2Level>,  "L2Level is a wire format");
+
+class L2Book {
+    /*
+    * Price levels rebuilt from an L2 feed, and where in the feed they are.
+    */
+
+public:
+    map<Price, Quantity, greater<Price>> bids; // Best (highest) first.
+    map<Price, Quantity, less<Price>>    asks; // Best (lowest) first.
+
+    /*
+    * @brief
+    * Apply one feed message. A snapshot replaces all levels; a delta is applied only if it is the next
+    * one after the last message applied.
+    *
+    * @return: false if a delta was ignored - before the first snapshot, or after a gap (which also
+    * drops the levels until the next snapshot).
+    */
+    bool apply(const L2Header& header, span<const L2Level> levels);
+
+    // Set a level to its new total volume, removing it at 0.
+    void set_level(const L2Level& level);
+
+    bool synced() const { return is_synced; }
+
+    // Sequence of the last message applied.
+    uint64_t sequence() const { return last_sequence; }
+
+    // Volume of a level, 0 if there is none.
+    Quantity volume(char side, Price price) const;
+
+    // The best levels of each side, like OrderBook::depth.
+    DepthSnapshot depth(size_t levels = MAX_DEPTH) const;
+
+private:
+    bool     is_synced     = false;
+    uint64_t last_sequence = 0;
+};
+
+class L2FeedSink : public EventSink {
+    /*
+    * Writes the L2 feed of a book to a stream. See the top of the file.
+    */
+
+private:
+    ostream&        out;
+    uint64_t        snapshot_interval;
+    vector<L2Level> pending;   // Coalesced level changes since the last flush, one entry per level.
+    L2Book          published; // Levels as of the last delta written.
+
+    void write(L2MessageType type, span<const L2Level> levels);
+
+public:
+    /*
+    * @param out: Binary stream the messages are written to.
+    * @param snapshot_interval: Deltas between two snapshots; 0 writes only the initial one.
+    */
+    explicit L2FeedSink(ostream& out, uint64_t snapshot_interval = L2_SNAPSHOT_INTERVAL);
+
+    void on_book_update(const BookUpdateEvent& update) override;
+
+    // Write the coalesced changes as one delta, and a snapshot if one is due.
+    void flush() override;
+
+    // Write a snapshot of all levels now, stamped with the sequence of the last delta.
+    void write_snapshot();
+
+    // Sequence of the last delta written.
+    uint64_t sequence() const { return published.sequence(); }
+};
+
+/*
+* @brief
+* Read the next message of an L2 feed.
+*
+* @return: false at the end of the stream or on a truncated message.
+*/
+bool read_l2_message(istream& in, L2Header& header, vector<L2Level>& levels);
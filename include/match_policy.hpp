@@ -0,0 +1,267 @@
+/*
+* Match policies of the order books: how an incoming order is filled against one price level.
+*
+* A book is a template over a MatchPolicy, and fills each level with LevelFill<Policy>. Every choice
+* below is an if constexpr on the policy, so a book only contains the code of its own policy - plain
+* price-time priority (PriceTimePolicy, what OrderBook and PriceLadderBook are) compiles to the same
+* FIFO loop as if no other policy existed.
+*
+* Self-trade prevention - what happens when the incoming order meets a resting order of its own
+* account (see risk_checker.hpp for accounts):
+*   - CANCEL_NEWEST: the rest of the incoming order is dropped, as if it were IOC; the resting order stays.
+*   - CANCEL_OLDEST: the resting order is cancelled and matching carries on.
+*   - DECREMENT:     both are reduced by the smaller of their quantities, without a trade; the resting
+*                    order is cancelled if nothing is left of it, amended otherwise.
+* The cancel and modify events of resting orders these publish carry AmendReason::SELF_TRADE.
+*
+* Allocation - how an order that does not take a whole level is shared among the orders in it:
+*   - FifoAllocation:    in time priority, each resting order filled in full before the next.
+*   - ProRataAllocation: in proportion to the resting quantities, rounded down, with the lots left by
+*                        rounding handed out one per order in time priority.
+*
+* Notes:
+*   - The FOK check runs before matching and does not know about self-trade prevention, so a FOK order
+*     that meets its own orders may end up partly filled.
+*
+* Usage:
+*   using ProRataBook = BasicOrderBook<MatchPolicy<SelfTradePrevention::DECREMENT, ProRataAllocation>>;
+*   ProRataBook order_book(DEFAULT_TICK_SIZE, &sink);
+*/
+
+#pragma once
+
+#include "event_sink.hpp"
+#include "order_pool.hpp"
+#include "price.hpp"
+#include "price_level.hpp"
+#include <algorithm>
+#include <cassert>
+#include <type_traits>
+using namespace std;
+
+enum class SelfTradePrevention {
+    NONE,
+    CANCEL_NEWEST,
+    CANCEL_OLDEST,
+    DECREMENT
+};
+
+struct FifoAllocation {};
+struct ProRataAllocation {};
+
+template <SelfTradePrevention SELF_TRADE = SelfTradePrevention::NONE, class Allocation = FifoAllocation>
+struct MatchPolicy {
+    static constexpr SelfTradePrevention self_trade = SELF_TRADE;
+    static constexpr bool                pro_rata   = is_same_v<Allocation, ProRataAllocation>;
+};
+
+// Price-time priority with no self-trade prevention.
+using PriceTimePolicy = MatchPolicy<>;
+
+template <class Policy>
+struct LevelFill {
+    /*
+    * The fill of one level of the opposite side under Policy. Works on the internals of a book
+    * (order_pool, order_index, sink, risk, instrumentation, level_updated), which is a friend, and on
+    * its levels whatever quantity type they store; trades and events always carry 64-bit quantities.
+    */
+
+    static constexpr bool prevents_self_trades = Policy::self_trade != SelfTradePrevention::NONE;
+
+    /*
+    * @brief
+    * Fill an incoming order against the queue of one level. The level's new total volume is published
+    * before returning.
+    *
+    * @return: the quantity of the incoming order left unfilled (0 also when self-trade prevention dropped
+    * it); the level may be left empty.
+    */
+    template <class Book, class Level>
+    static Quantity fill(Book& book, Level& level, Price level_price, OrderId taker_id, char taker_side,
+                         AccountId taker_account, Quantity quantity) {
+        if constexpr (Policy::pro_rata) {
+            if constexpr (prevents_self_trades) {
+                char maker_side = taker_side == 'B' ? 'S' : 'B';
+
+                // Deal with the incoming order's own orders first, so the level is shared among other accounts only.
+                for (OrderHandle handle = level.head; handle != NULL_ORDER && quantity > 0;) {
+                    OrderHandle next = book.order_pool[handle].next;
+                    if (book.order_pool.info(handle).account == taker_account) {
+                        if (Policy::self_trade == SelfTradePrevention::CANCEL_NEWEST) return 0; // Level unchanged.
+                        quantity -= prevent_self_trade(book, level, handle, level_price, maker_side, quantity);
+                    }
+                    handle = next;
+                }
+                if (quantity == 0 || level.empty()) {
+                    book.level_updated(maker_side, level_price, level.total_volume);
+                    return quantity;
+                }
+            }
+            if (quantity >= level.total_volume) return sweep(book, level, level_price, taker_id, taker_side, quantity);
+            return fill_pro_rata(book, level, level_price, taker_id, taker_side, quantity);
+        } else if constexpr (prevents_self_trades) {
+            return fill_fifo_preventing_self_trades(book, level, level_price, taker_id, taker_side, taker_account, quantity);
+        } else {
+            if (quantity >= level.total_volume) return sweep(book, level, level_price, taker_id, taker_side, quantity);
+            return fill_fifo(book, level, level_price, taker_id, taker_side, quantity);
+        }
+    }
+
+private:
+    // Record a trade of a resting order, without touching its quantity.
+    template <class Book>
+    static void trade(Book& book, OrderHandle handle, Price level_price, OrderId taker_id, char taker_side, Quantity quantity) {
+        // The resting order is the maker and sets the trade price.
+        book.sink->on_trade(TradeEvent{book.order_pool[handle].id, taker_id, taker_side, level_price, quantity});
+        book.instrumentation.fill();
+        if (book.risk != nullptr) book.risk->closed(book.order_pool.info(handle).account, quantity);
+    }
+
+    // Sweep: an order that covers the level's total volume takes every order in it whole. Fill them in a
+    // single walk down the queue, with no per-fill quantity updates, and free the queue in bulk.
+    template <class Book, class Level>
+    static Quantity sweep(Book& book, Level& level, Price level_price, OrderId taker_id, char taker_side, Quantity quantity) {
+        size_t filled = 0;
+        for (OrderHandle handle = level.head; handle != NULL_ORDER; handle = book.order_pool[handle].next) {
+            const auto& maker = book.order_pool[handle];
+            trade(book, handle, level_price, taker_id, taker_side, maker.quantity);
+            book.order_index.erase(maker.id);
+            filled++;
+        }
+        quantity -= level.total_volume;
+        level.clear(book.order_pool, filled);
+
+        book.level_updated(taker_side == 'B' ? 'S' : 'B', level_price, 0);
+        return quantity;
+    }
+
+    // The level outlasts the order: fill from the front until the order is done.
+    template <class Book, class Level>
+    static Quantity fill_fifo(Book& book, Level& level, Price level_price, OrderId taker_id, char taker_side, Quantity quantity) {
+        while (quantity > 0) {
+            auto& maker = book.order_pool[level.head];
+            Quantity trade_quantity = min<Quantity>(quantity, maker.quantity);
+            trade(book, level.head, level_price, taker_id, taker_side, trade_quantity);
+
+            // Update order quantities as per executed trade
+            maker.quantity     -= trade_quantity;
+            level.total_volume -= trade_quantity;
+            quantity           -= trade_quantity;
+
+            if (maker.quantity == 0) {
+                book.order_index.erase(maker.id);
+                level.pop_front(book.order_pool);
+            }
+        }
+        // Total volume of orders at price is 0 <=> the queue of orders at that price is empty.
+        assert(!level.empty() && level.total_volume > 0);
+
+        book.level_updated(taker_side == 'B' ? 'S' : 'B', level_price, level.total_volume);
+        return quantity;
+    }
+
+    // fill_fifo, checking the account of each resting order before it trades.
+    template <class Book, class Level>
+    static Quantity fill_fifo_preventing_self_trades(Book& book, Level& level, Price level_price, OrderId taker_id,
+                                                     char taker_side, AccountId taker_account, Quantity quantity) {
+        char maker_side = taker_side == 'B' ? 'S' : 'B';
+        while (quantity > 0 && !level.empty()) {
+            OrderHandle handle = level.head;
+            if (book.order_pool.info(handle).account == taker_account) {
+                if (Policy::self_trade == SelfTradePrevention::CANCEL_NEWEST) {
+                    quantity = 0;
+                    break;
+                }
+                quantity -= prevent_self_trade(book, level, handle, level_price, maker_side, quantity);
+                continue;
+            }
+
+            auto& maker = book.order_pool[handle];
+            Quantity trade_quantity = min<Quantity>(quantity, maker.quantity);
+            trade(book, handle, level_price, taker_id, taker_side, trade_quantity);
+            maker.quantity     -= trade_quantity;
+            level.total_volume -= trade_quantity;
+            quantity           -= trade_quantity;
+
+            if (maker.quantity == 0) {
+                book.order_index.erase(maker.id);
+                level.pop_front(book.order_pool);
+            }
+        }
+        assert(level.empty() == (level.total_volume == 0));
+
+        book.level_updated(maker_side, level_price, level.total_volume);
+        return quantity;
+    }
+
+    /*
+    * Apply CANCEL_OLDEST or DECREMENT to a resting order of the incoming order's own account: take quantity
+    * off it without a trade, cancelling it if nothing is left.
+    *
+    * @return: the quantity to take off the incoming order - 0 for CANCEL_OLDEST.
+    */
+    template <class Book, class Level>
+    static Quantity prevent_self_trade(Book& book, Level& level, OrderHandle handle, Price level_price, char maker_side,
+                                       Quantity quantity) {
+        auto&            maker     = book.order_pool[handle];
+        const auto&      info      = book.order_pool.info(handle);
+        bool             decrement = Policy::self_trade == SelfTradePrevention::DECREMENT;
+        Quantity         reduction = decrement ? min<Quantity>(quantity, maker.quantity) : maker.quantity;
+
+        if (book.risk != nullptr) book.risk->closed(info.account, reduction);
+        if (reduction == maker.quantity) {
+            book.sink->on_cancel(CancelEvent{maker.id, maker_side, level_price, maker.quantity, AmendReason::SELF_TRADE});
+            book.order_index.erase(maker.id);
+            level.remove(book.order_pool, handle);
+        } else {
+            maker.quantity     -= reduction;
+            level.total_volume -= reduction;
+            book.sink->on_modify(ModifyEvent{maker.id, maker_side, level_price, maker.quantity, info.sequence,
+                                             AmendReason::SELF_TRADE});
+        }
+        return decrement ? reduction : 0;
+    }
+
+    // Share of an order of resting quantity among total_volume in an incoming quantity, rounded down.
+    // The product is taken in 128 bits, as both factors may be large.
+    static Quantity pro_rata_share(Quantity quantity, Quantity resting, Quantity total_volume) {
+        __extension__ using Wide = __int128;
+        return static_cast<Quantity>(static_cast<Wide>(quantity) * resting / total_volume);
+    }
+
+    // Share an order smaller than the level among all its orders, in proportion to their quantities.
+    template <class Book, class Level>
+    static Quantity fill_pro_rata(Book& book, Level& level, Price level_price, OrderId taker_id, char taker_side,
+                                  Quantity quantity) {
+        Quantity total_volume = level.total_volume;
+
+        // The lots that rounding down leaves over go one per order in time priority, so the order fills in full.
+        Quantity left_over = quantity;
+        for (OrderHandle handle = level.head; handle != NULL_ORDER; handle = book.order_pool[handle].next)
+            left_over -= pro_rata_share(quantity, book.order_pool[handle].quantity, total_volume);
+
+        for (OrderHandle handle = level.head; handle != NULL_ORDER;) {
+            auto&       maker = book.order_pool[handle];
+            OrderHandle next  = maker.next;
+            Quantity    share = pro_rata_share(quantity, maker.quantity, total_volume);
+            if (left_over > 0 && share < maker.quantity) {
+                share++;
+                left_over--;
+            }
+            if (share > 0) {
+                trade(book, handle, level_price, taker_id, taker_side, share);
+                maker.quantity     -= share;
+                level.total_volume -= share;
+                if (maker.quantity == 0) {
+                    book.order_index.erase(maker.id);
+                    level.remove(book.order_pool, handle);
+                }
+            }
+            handle = next;
+        }
+        assert(left_over == 0 && level.total_volume == total_volume - quantity);
+
+        book.level_updated(taker_side == 'B' ? 'S' : 'B', level_price, level.total_volume);
+        return 0;
+    }
+};
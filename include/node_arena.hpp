@@ -0,0 +1,156 @@
+/*
+* Fixed-size block arena and the allocator that lets node-based standard containers draw from it.
+*
+* Every node of a std::map has the same size, so an arena handing out blocks of that size from
+* chunks and recycling them through a free list serves all node allocations of the map. Inserting
+* and erasing price levels then only reaches the global allocator when the arena needs a new chunk.
+* trim() hands back the chunks that no longer hold a block in use.
+*
+* Usage:
+*   NodeArena arena;
+*   map<Price, PriceLevel, less<Price>, ArenaAllocator<pair<const Price, PriceLevel>>> levels(&arena);
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+using namespace std;
+
+class NodeArena {
+public:
+    // Blocks per chunk.
+    static constexpr size_t CHUNK_SIZE = 1024;
+
+    NodeArena() = default;
+    NodeArena(const NodeArena&)            = delete;
+    NodeArena& operator=(const NodeArena&) = delete;
+
+    // Allocate a block. All blocks of an arena have the size of the first request.
+    void* allocate(size_t bytes) {
+        if (block_size == 0) block_size = round_up(bytes);
+        if (bytes > block_size) return ::operator new(bytes);
+
+        if (free_head == nullptr) grow();
+        FreeBlock* block = free_head;
+        free_head = block->next;
+        in_use++;
+        return block;
+    }
+
+    void deallocate(void* pointer, size_t bytes) {
+        if (bytes > block_size) return ::operator delete(pointer);
+
+        FreeBlock* block = static_cast<FreeBlock*>(pointer);
+        block->next = free_head;
+        free_head = block;
+        in_use--;
+    }
+
+    // Blocks currently handed out.
+    size_t size() const { return in_use; }
+
+    // Blocks allocated or free.
+    size_t capacity() const { return chunks.size() * CHUNK_SIZE; }
+
+    // Bytes of the chunks, i.e. the arena's footprint.
+    size_t bytes() const { return capacity() * block_size; }
+
+    // Bytes of the blocks handed out.
+    size_t bytes_in_use() const { return in_use * block_size; }
+
+    /*
+    * @brief
+    * Free every chunk none of whose blocks is handed out. Walks the free list twice, O(free blocks x log chunks).
+    *
+    * @return: number of chunks freed.
+    */
+    size_t trim() {
+        if (chunks.empty()) return 0;
+
+        // Chunks by address, so the chunk of a free block is found by binary search.
+        vector<pair<uintptr_t, size_t>> starts;
+        starts.reserve(chunks.size());
+        for (size_t i = 0; i < chunks.size(); i++) starts.emplace_back(reinterpret_cast<uintptr_t>(chunks[i].get()), i);
+        sort(starts.begin(), starts.end());
+        auto chunk_of = [&](const FreeBlock* block) {
+            auto after = upper_bound(starts.begin(), starts.end(), make_pair(reinterpret_cast<uintptr_t>(block), SIZE_MAX));
+            return prev(after)->second;
+        };
+
+        vector<size_t> free_blocks(chunks.size(), 0);
+        for (FreeBlock* block = free_head; block != nullptr; block = block->next) free_blocks[chunk_of(block)]++;
+
+        // Unlink the blocks of the chunks that go, keeping the order of the rest.
+        FreeBlock** link = &free_head;
+        for (FreeBlock* block = free_head; block != nullptr; block = block->next) {
+            if (free_blocks[chunk_of(block)] == CHUNK_SIZE) continue;
+            *link = block;
+            link  = &block->next;
+        }
+        *link = nullptr;
+
+        size_t kept = 0;
+        for (size_t i = 0; i < chunks.size(); i++)
+            if (free_blocks[i] != CHUNK_SIZE) chunks[kept++] = move(chunks[i]);
+        size_t freed = chunks.size() - kept;
+        chunks.resize(kept);
+        chunks.shrink_to_fit();
+        return freed;
+    }
+
+private:
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    vector<unique_ptr<byte[]>> chunks;
+    FreeBlock* free_head  = nullptr;
+    size_t     block_size = 0;
+    size_t     in_use     = 0;
+
+    static size_t round_up(size_t bytes) {
+        size_t align = alignof(max_align_t);
+        bytes = bytes < sizeof(FreeBlock) ? sizeof(FreeBlock) : bytes;
+        return (bytes + align - 1) / align * align;
+    }
+
+    void grow() {
+        // operator new[] aligns to __STDCPP_DEFAULT_NEW_ALIGNMENT__, which covers max_align_t.
+        chunks.emplace_back(make_unique<byte[]>(block_size * CHUNK_SIZE));
+        byte* chunk = chunks.back().get();
+        for (size_t i = CHUNK_SIZE; i-- > 0;) {
+            FreeBlock* block = reinterpret_cast<FreeBlock*>(chunk + i * block_size);
+            block->next = free_head;
+            free_head = block;
+        }
+    }
+};
+
+// Standard allocator adaptor over a NodeArena. Single-object allocations come from the arena,
+// anything else (which node containers don't ask for) falls back to the global allocator.
+template <class T>
+struct ArenaAllocator {
+    using value_type = T;
+
+    NodeArena* arena;
+
+    ArenaAllocator(NodeArena* arena) : arena(arena) {}
+    template <class U> ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.arena) {}
+
+    T* allocate(size_t n) {
+        if (n != 1) return static_cast<T*>(::operator new(n * sizeof(T)));
+        return static_cast<T*>(arena->allocate(sizeof(T)));
+    }
+
+    void deallocate(T* pointer, size_t n) {
+        if (n != 1) return ::operator delete(pointer);
+        arena->deallocate(pointer, sizeof(T));
+    }
+
+    template <class U> bool operator==(const ArenaAllocator<U>& other) const { return arena == other.arena; }
+};
@@ -2,89 +2,418 @@
 * Defines the OrderBook class for managing market orders.
 *
 * OrderBook maintains active buy and sell orders, matching them according to price-time priority.
-* It exposes functions to add new orders, execute trades and display the order book.
+* It exposes functions to add new orders, execute trades and display the order book. OrderBook is
+* BasicOrderBook<PriceTimePolicy>; other instantiations add self-trade prevention or pro-rata
+* allocation (see match_policy.hpp) at no cost to this one. The book stores prices and quantities as
+* PriceT and QtyT, 64-bit by default; OrderBook32 stores them in 32 bits for denser levels and orders,
+* and rejects what does not fit. Its interface and events stay 64-bit either way.
 *
 * Usage:
-*   OrderBook order_book;
+*   OrderBook order_book;                                 // Tick size 0.001, or OrderBook order_book(TickSize{2, 5});
 *   order_book.add_order('B', "50", "10.39", 1730764173);
+*   order_book.add_order('B', 50, 10390, 1730764174);   // Already parsed: price in 0.001 units
 */
 
+#pragma once
+
+#include "book_display.hpp"
+#include "book_footprint.hpp"
+#include "book_stats.hpp"
+#include "depth_cache.hpp"
+#include "event_sink.hpp"
+#include "match_policy.hpp"
+#include "node_arena.hpp"
+#include "order_index.hpp"
+#include "order_parser.hpp"
+#include "order_pool.hpp"
+#include "order_record.hpp"
+#include "order_request.hpp"
+#include "order_tokenizer.hpp"
+#include "price.hpp"
+#include "price_level.hpp"
+#include "risk_checker.hpp"
+#include <cstdint>
+#include <functional>
 #include <iostream>
+#include <limits>
 #include <map>
 #include <queue>
+#include <span>
 #include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
 using namespace std;
 
-// Used to display Order book columns - BUY and SELL
-const size_t COLUMN_WIDTH      = 15; 
-const string ORDER_BOOK_HEADER = "BUY            |           SELL"; 
+template <char SIDE, class PriceT = Price, class QtyT = Quantity>
+struct BookSide {
+    /*
+    * The price levels of one side of an OrderBook, ordered by a comparator fixed at compile time so that
+    * begin() is always the best level - the highest bid or the lowest ask - and "does an incoming order
+    * at this price reach the best level" is one comparison with no test of the side. Levels are keyed by
+    * PriceT and hold QtyT totals; the comparator works on 64-bit prices, so incoming prices are never narrowed.
+    */
+
+    using Level    = BasicPriceLevel<QtyT>;
+    using Compare  = conditional_t<SIDE == 'B', greater<Price>, less<Price>>;
+    using LevelMap = map<PriceT, Level, Compare, ArenaAllocator<pair<const PriceT, Level>>>;
 
- // We scale price by this factor and remove the decimal part, which is essentially 
- // enforcing a tick size of 0.001
-const long SCALE_FACTOR = 1000;
+    static constexpr char side = SIDE;
 
-// A basic structure of an order. Note that the price here is scaled and hence in "long" type
-struct Order {
-    char side;
-    long quantity;
-    long price;
-    long timestamp;
+    LevelMap levels;
 
-    Order (char s, long q, long p, long t) : side(s), quantity(q), price(p), timestamp(t) {} 
+    explicit BookSide(NodeArena* arena) : levels(Compare(), ArenaAllocator<pair<const PriceT, Level>>(arena)) {}
+
+    // Whether an order of the other side at this price trades against a level at level_price, i.e. level_price
+    // is at or better than price from this side's point of view.
+    static bool reaches(Price price, Price level_price) { return !Compare()(price, level_price); }
+
+    // Whether an order of the other side at this price trades against the best level.
+    bool crossed_by(Price price) const { return !levels.empty() && reaches(price, levels.begin()->first); }
 };
 
-class OrderBook {
+template <class Policy = PriceTimePolicy, class PriceT = Price, class QtyT = Quantity>
+class BasicOrderBook {
     /*
     * Maintains an Exchange Order Book and provides the following functionalities:
     * - Add a new order (side, quantity, price, timestamp)
-    * - Execute trades by matching the orders (and also print them)
+    * - Cancel or modify a resting order by the id add_order returned
+    * - Match each incoming order against the opposite side as it is added (and publish the trades to an EventSink)
     * - Print Order Book status
     *
     * Data structure used:
-    *  - An ordered map (a balanced binary tree) from scaled price to a queue of 
-    *    unmatched orders submitted at that price.
-    *  - Another ordered map with the same keys as above, the values being the 
-    *    total volume of unmatched orders at that price.
-    *
-    * TODO: 
-    * We could use a single multi-map instead of two maps with same keys at all times. 
-    * I've used two just for simplicity.
+    *  - An ordered map (a balanced binary tree) from scaled price to a price level - the queue
+    *    of unmatched orders submitted at that price along with their total volume - per side. Each side
+    *    is a BookSide ordered best price first, and the code that works on a side is a template
+    *    instantiated once per side, so it never asks which side it is on.
+    *  - Orders are nodes of an OrderPool linked into their level's queue, and map nodes come from
+    *    a NodeArena, so neither orders nor levels touch the global allocator once the book is warm.
+    *  - An open-addressing hash index from order id to pool node, for cancel and modify.
+    *  - Prices are stored as PriceT and quantities (of orders and of levels) as QtyT. Narrower types than
+    *    Price and Quantity shrink the order info and the level map nodes; the book then rejects prices with
+    *    PRICE_OUT_OF_RANGE and quantities with QUANTITY_OUT_OF_RANGE that it could not store, including an
+    *    order or a modify that would take the total volume of its level past QtyT.
     */
 
+    static_assert(is_signed_v<PriceT> && sizeof(PriceT) <= sizeof(Price),
+                  "PriceT must be signed and no wider than Price");
+    static_assert(is_signed_v<QtyT> && sizeof(QtyT) <= sizeof(Quantity),
+                  "QtyT must be signed and no wider than Quantity");
+
 private:
-    // Orders are maintained in a queue, keyed by price in an ordered map.
-    map<long, deque<Order>> buy_orders;
-    map<long, deque<Order>> sell_orders;
+    using Pool  = BasicOrderPool<PriceT, QtyT>;
+    using Level = BasicPriceLevel<QtyT>;
+
+    // Precision and tick of every price in this book.
+    TickSize tick_size;
+
+    // Where trades and all other book events go. Defaults to printing_sink.
+    PrintingSink printing_sink;
+    EventSink*   sink;
+
+    // Pre-trade limits and open quantity per account, if any (see set_risk).
+    RiskChecker* risk = nullptr;
+
+    // Storage for orders and for the map nodes of price levels. Declared before the maps that use them.
+    Pool      order_pool;
+    NodeArena level_arena;
+
+    // Resting orders by id, for cancel and modify.
+    OrderIndex order_index;
+
+    // Id given to the next accepted order.
+    OrderId next_order_id = 1;
+
+    // Sequence number given to the next order that joins the back of a level. Priority within a level
+    // follows it, never the caller's timestamps.
+    uint64_t next_sequence = 1;
+
+    // Price levels (order queue and total volume), keyed by price in an ordered map, best level first.
+    BookSide<'B', PriceT, QtyT> buy_orders;
+    BookSide<'S', PriceT, QtyT> sell_orders;
+
+    // Call f with the side a 'B' or 'S' order rests on - f is instantiated for each, so its body
+    // works on one known side.
+    template <class F>
+    decltype(auto) on_side(char side, F&& f) { return side == 'B' ? f(buy_orders) : f(sell_orders); }
+
+    // Best levels of each side, patched on every level update (see depth_cache.hpp).
+    DepthCache depth_cache;
+
+    // Frame buffer of print_order_book, kept between calls.
+    BookRenderer renderer;
+
+    // Latency histograms and matching counters; empty unless built with MARKET_ENGINE_INSTRUMENT.
+    [[no_unique_address]] BookInstrumentation instrumentation;
+
+    // Publish the new total volume of a level and keep the depth cache in step. Called wherever a total changes.
+    void level_updated(char side, Price price, Quantity total_volume) {
+        depth_cache.update(side, price, total_volume);
+        if (total_volume == 0) instrumentation.level_destroyed(side);
+        sink->on_book_update(BookUpdateEvent{side, price, total_volume});
+    }
+
+    // Each level is filled by the match policy, which works on the members above.
+    template <class> friend struct LevelFill;
+
+    /*
+    * Match an incoming order against the opposite side, best price first, for as long as it crosses.
+    * Each level is filled as the match policy says (see match_policy.hpp). Returns the quantity left to
+    * rest in the book.
+    */
+    Quantity match(OrderId id, char side, AccountId account, Quantity quantity, Price price);
+
+    // match against one side: an incoming order of the other side.
+    template <class Opposite>
+    Quantity match_side(Opposite& opposite, OrderId id, AccountId account, Quantity quantity, Price price);
+
+    // The level the previous order of a batch rested at, so the next order at that price skips the map lookup.
+    struct RestingLevel {
+        char   side  = 0;
+        Price  price = 0;
+        Level* level = nullptr;
+    };
+
+    /*
+    * add_order after validate_order: rejects or matches and rests the order, without flushing the sink.
+    * last_level, if given, is used and updated for batches.
+    */
+    OrderId accept_order(char side, Quantity quantity, Price price, long timestamp, OrderId id, OrderType order_type,
+                         AccountId account, ValidationResult validation_result, RestingLevel* last_level);
 
-    // Total volume at each price is stored in ordered maps.
-    map<long, long long> total_buy_orders_at_price;
-    map<long, long long> total_sell_orders_at_price;
+    // Whether an order at this price would trade against the opposite side on arrival.
+    bool crosses(char side, Price price) const;
+
+    // Whether a price or a quantity fits the type the book stores it in. Always true for 64-bit types.
+    static bool fits_price(Price price)          { return price <= numeric_limits<PriceT>::max(); }
+    static bool fits_quantity(Quantity quantity) { return quantity <= numeric_limits<QtyT>::max(); }
+
+    // Whether increase can be added to the total volume of a level without leaving QtyT.
+    static bool fits_level(const Level& level, Quantity increase) {
+        return increase <= numeric_limits<QtyT>::max() - level.total_volume;
+    }
+
+    /*
+    * PRICE_OUT_OF_RANGE or QUANTITY_OUT_OF_RANGE for an order whose price or quantity the book cannot store. VALID
+    * at no cost for 64-bit types. The total volume of the level it would rest at is checked by accept_order.
+    */
+    ValidationResult check_range(Quantity quantity, Price price, OrderType order_type) const;
+
+    /*
+    * Whether the opposite side holds at least quantity at prices an order at this price would trade at.
+    * Stops at the first level where the running total gets there.
+    */
+    bool can_fill(char side, Quantity quantity, Price price) const;
+
+    // cancel_order and modify_order without flushing the sink.
+    bool remove_order(OrderId id);
+    ValidationResult amend_order(OrderId id, Quantity new_quantity);
 
 public:
+    /*
+    * @param tick_size: Precision and tick size of prices. Text prices are truncated down to the tick.
+    * @param sink:      Receives trades and other book events; nullptr prints trades and rejections to cout.
+    */
+    explicit BasicOrderBook(TickSize tick_size = DEFAULT_TICK_SIZE, EventSink* sink = nullptr);
+
     /*
     * @brief
     * Create a new Order (buy or sell based on "side") object with the given price,
-    * quantity and timestamp. Timestamp is used to determine the price at which a
-    * trade should be executed, based on whether the buy or sell order came first.
+    * quantity and timestamp, and match it against the resting orders of the other side.
+    * Trades execute at the price of the resting order; whatever is left unfilled rests in the book,
+    * so the book is never left crossed.
     *
     * @param side:         'B' for buy or 'S for sell.
     * @param quantity_str: Order quantity as a string.
     * @param price_str:    Order price as a string.
-    * @param price_str:    Order price as a string.
     * @param timestamp:    Timestamp associated with the order.
     *
-    * @return: true if the order was added to the book successfully, false otherwise.
+    * @return: id of the new order, or INVALID_ORDER_ID if it was rejected.
+    */
+    OrderId add_order(char side, string_view quantity_str, string_view price_str, long timestamp);
+
+    /*
+    * @brief
+    * Same as above for an order that is already parsed, e.g. decoded from a binary feed.
+    * Skips text parsing entirely; only the cheap range checks of validate_order are applied.
+    *
+    * @param side:       'B' for buy or 'S for sell.
+    * @param quantity:   Order quantity.
+    * @param price:      Order price in 10^-decimals units of the book's tick size. Must be a multiple of the tick.
+    * @param timestamp:  Wall-clock time of the order, kept as metadata only. Priority is by the sequence number
+    *                    the book assigns on arrival.
+    * @param id:         Id chosen by the caller, e.g. carried by a feed. By default the book assigns the next one.
+    *                    An id that is already resting is rejected with DUPLICATE_ORDER_ID.
+    * @param order_type: LIMIT rests what is left after matching. MARKET (price ignored) and IOC drop it instead.
+    *                    FOK is rejected with INSUFFICIENT_LIQUIDITY unless it fills in full, and POST_ONLY
+    *                    with WOULD_CROSS if it would trade at all; neither trades when rejected.
+    * @param account:    Account the order is entered for; checked against its limits if the book has a RiskChecker.
+    *
+    * @return: id of the new order (also when nothing of it rested), or INVALID_ORDER_ID if it was rejected.
     */
-    bool add_order(char side, string quantity_str, string price_str, long timestamp);
+    OrderId add_order(char side, Quantity quantity, Price price, long timestamp = 0, OrderId id = INVALID_ORDER_ID,
+                      OrderType order_type = OrderType::LIMIT, AccountId account = DEFAULT_ACCOUNT);
 
     /*
-    * Match the highest bid with the least ask and print the corresponding trades in sequence.
+    * @brief
+    * Apply an add, cancel or modify request - the entry point for requests that arrive through a queue.
+    *
+    * @return: id of the order the request applied to, or INVALID_ORDER_ID if it was rejected or failed.
     */
-    void execute_and_print_trades();
+    OrderId submit(const OrderRequest& request);
+
+    /*
+    * @brief
+    * Apply a burst of add, cancel and modify requests in arrival order, with exactly the matching and
+    * events of calling submit() on each - but the adds are validated in one pass up front, consecutive
+    * orders resting at the same level share one level lookup, and the sink is flushed once at the end.
+    *
+    * @param requests: Requests in arrival order.
+    * @param ids:      Optional, at least requests.size() entries: what submit() would have returned for each.
+    *
+    * @return: number of requests that were accepted (adds) or succeeded (cancels and modifies).
+    */
+    size_t add_orders(span<const OrderRequest> requests, span<OrderId> ids = {});
+
+    /*
+    * @brief
+    * Same as above for a column batch of new orders from tokenize_orders. Rows are taken in order with
+    * the results the tokenizer gave them (text that did not parse is rejected as by the text add_order),
+    * and get book-assigned ids and timestamps first_timestamp, first_timestamp + 1, ...
+    *
+    * @return: number of orders accepted.
+    */
+    size_t add_orders(const OrderColumns& orders, long first_timestamp, span<OrderId> ids = {});
+
+    /*
+    * @brief
+    * Remove a resting order from the book. The order is found through the id index, no level is scanned.
+    *
+    * @return: true if the order was resting and is now cancelled, false if the id is unknown or already filled.
+    */
+    bool cancel_order(OrderId id);
+
+    /*
+    * @brief
+    * Change the remaining quantity of a resting order. Reducing the quantity keeps the order's time
+    * priority; increasing it moves the order to the back of its price level.
+    *
+    * @return: VALID if the order was amended; UNKNOWN_ORDER_ID if the id is not resting; INVALID_QUANTITY if
+    * new_quantity is not positive; QUANTITY_OUT_OF_RANGE if the level's total volume would not fit QtyT; or,
+    * for an increase, the limit of the order's account it would break - ORDER_QUANTITY_LIMIT, NOTIONAL_LIMIT or
+    * EXPOSURE_LIMIT (see set_risk), which is also published to the sink as a RejectEvent.
+    */
+    ValidationResult modify_order(OrderId id, Quantity new_quantity);
 
     /* 
     * Print the current state of the order book i.e only the unmatched orders.
     * Orders are group by price (using the map) and we display them in price-priority: highest bid and lowest ask first.
+    * The frame is built in a reused buffer and written with one write - call it on demand, matching never needs it.
+    *
+    * @param max_levels: Rows to print, i.e. levels per side; the default prints every level.
+    */
+    void print_order_book(size_t max_levels = SIZE_MAX);
+
+    /*
+    * Best bid and best ask with their total volume, read straight off the ends of the book.
+    */
+    TopOfBook top_of_book() const;
+
+    /*
+    * @brief
+    * The best levels of each side. Served from the incrementally kept depth cache; a side is only
+    * re-read from the book - its first MAX_DEPTH levels - if a top level was removed since the last call.
+    *
+    * @param levels: Levels per side wanted, at most MAX_DEPTH.
     */
-    void print_order_book();
-};
\ No newline at end of file
+    DepthSnapshot depth(size_t levels = MAX_DEPTH);
+
+    // Precision and tick of every price in this book.
+    TickSize tick() const { return tick_size; }
+
+    /*
+    * Id the next order the book accepts will get, unless the caller chooses one.
+    */
+    OrderId next_id() const { return next_order_id; }
+
+    /*
+    * Send all further events to another sink, e.g. to restore a book silently; nullptr prints them to cout.
+    */
+    void set_sink(EventSink* new_sink) { sink = new_sink ? new_sink : &printing_sink; }
+
+    /*
+    * Check every further add against the limits of its account before it is matched, and keep the
+    * accounts' open quantities in risk; nullptr turns the checks off. Attach it before any order rests.
+    */
+    void set_risk(RiskChecker* new_risk) { risk = new_risk; }
+
+    /*
+    * @brief
+    * Append every resting order to orders - buys then sells, each side best price first and each level
+    * in time priority - in the form restore() takes back.
+    */
+    void export_orders(vector<OrderRecord>& orders) const;
+
+    /*
+    * @brief
+    * Bulk-load resting orders into an empty book, e.g. from a snapshot. The orders are linked straight into
+    * their levels with no matching and no events, and keep their ids, timestamps and time priority.
+    *
+    * @param orders:        Resting orders in the order export_orders writes them.
+    * @param next_order_id: Id the next order will get (raised past the largest id restored if needed).
+    *                       Restored orders get fresh sequence numbers in the order given.
+    *
+    * @return: false, with the book left unchanged, if the book is not empty or an order is invalid for it
+    *          (side, quantity, price outside the book, or a duplicate id).
+    */
+    bool restore(span<const OrderRecord> orders, OrderId next_order_id);
+
+    /*
+    * Most orders resting in the book at the same time - the size the order pool had to grow to.
+    */
+    size_t order_pool_high_water_mark() const { return order_pool.high_water_mark(); }
+
+    // Bytes the book holds, and how much of them is in use (see book_footprint.hpp).
+    BookFootprint footprint() const;
+
+    /*
+    * @brief
+    * Give back storage the book no longer needs: order pool chunks beyond those the resting orders fill
+    * (moving the orders in them into free nodes lower down), level arena chunks with no level left, and
+    * an order index table more than twice the size it needs. Orders keep their ids, levels and priority,
+    * and no events are published.
+    *
+    * Meant for idle time: each call walks the pool's and the arena's free lists once and moves at most
+    * max_chunks x Pool::CHUNK_SIZE orders, so a caller can spread a large compaction over several
+    * idle cycles.
+    *
+    * @param max_chunks: Most order pool chunks to drop in this call.
+    *
+    * @return: bytes given back.
+    */
+    size_t compact(size_t max_chunks = SIZE_MAX);
+
+    /*
+    * Snapshot of the latency histograms and counters (see book_stats.hpp). All zero unless the book
+    * was built with MARKET_ENGINE_INSTRUMENT.
+    */
+    BookStats stats() const { return instrumentation.stats(); }
+};
+
+// Price-time priority, the book used throughout.
+using OrderBook = BasicOrderBook<>;
+
+// Price-time priority for instruments whose prices, in units of the tick size's precision, and quantities fit in
+// 32 bits: 32-byte order info instead of 40 and 48-byte level map nodes instead of 64 (see book_footprint.hpp).
+using OrderBook32 = BasicOrderBook<PriceTimePolicy, int32_t, int32_t>;
+
+// The match policies the library is built with (see the end of the .cpp).
+extern template class BasicOrderBook<PriceTimePolicy>;
+extern template class BasicOrderBook<PriceTimePolicy, int32_t, int32_t>;
+extern template class BasicOrderBook<MatchPolicy<SelfTradePrevention::CANCEL_NEWEST>>;
+extern template class BasicOrderBook<MatchPolicy<SelfTradePrevention::CANCEL_OLDEST>>;
+extern template class BasicOrderBook<MatchPolicy<SelfTradePrevention::DECREMENT>>;
+extern template class BasicOrderBook<MatchPolicy<SelfTradePrevention::NONE, ProRataAllocation>>;
+extern template class BasicOrderBook<MatchPolicy<SelfTradePrevention::CANCEL_NEWEST, ProRataAllocation>>;
+extern template class BasicOrderBook<MatchPolicy<SelfTradePrevention::CANCEL_OLDEST, ProRataAllocation>>;
+extern template class BasicOrderBook<MatchPolicy<SelfTradePrevention::DECREMENT, ProRataAllocation>>;
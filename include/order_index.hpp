@@ -0,0 +1,129 @@
+/*
+* Open-addressing hash index from order id to the pool node of a resting order.
+*
+* Linear probing over a power-of-two table of (id, handle) slots, kept at most half full. Deletion
+* shifts the following entries of the probe run back instead of leaving tombstones, so lookups
+* never slow down as orders come and go - the index sees one insert and one erase per order.
+*
+* Usage:
+*   OrderIndex index;
+*   index.insert(42, handle);
+*   index.find(42);          // handle
+*   index.erase(42);
+*/
+
+#pragma once
+
+#include "order_pool.hpp"
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+using namespace std;
+
+class OrderIndex {
+public:
+    /*
+    * @param expected_orders: Orders expected to rest at the same time; the table holds twice as many slots.
+    */
+    explicit OrderIndex(size_t expected_orders = 4096) {
+        size_t capacity = 16;
+        while (capacity < 2 * expected_orders) capacity *= 2;
+        min_capacity = capacity;
+        resize(capacity);
+    }
+
+    // Handle of the order with this id, NULL_ORDER if it is not in the index.
+    OrderHandle find(OrderId id) const {
+        for (size_t i = slot_of(id);; i = (i + 1) & mask) {
+            if (slots[i].id == id)               return slots[i].handle;
+            if (slots[i].id == INVALID_ORDER_ID) return NULL_ORDER;
+        }
+    }
+
+    // Add an id that is not in the index yet.
+    void insert(OrderId id, OrderHandle handle) {
+        if (2 * (count + 1) > slots.size()) resize(2 * slots.size());
+        place(id, handle);
+        count++;
+    }
+
+    // Remove an id, returning false if it was not in the index.
+    bool erase(OrderId id) {
+        size_t i = slot_of(id);
+        while (slots[i].id != id) {
+            if (slots[i].id == INVALID_ORDER_ID) return false;
+            i = (i + 1) & mask;
+        }
+
+        // Backward-shift deletion: pull later entries of the run into the hole whenever the hole
+        // lies between their home slot and their current slot.
+        for (size_t j = (i + 1) & mask; slots[j].id != INVALID_ORDER_ID; j = (j + 1) & mask) {
+            size_t home = slot_of(slots[j].id);
+            if (((j - home) & mask) >= ((j - i) & mask)) {
+                slots[i] = slots[j];
+                i = j;
+            }
+        }
+        slots[i] = Slot{};
+        count--;
+        return true;
+    }
+
+    // Point an id that is in the index at another handle, e.g. after its node moved.
+    void update(OrderId id, OrderHandle handle) {
+        size_t i = slot_of(id);
+        while (slots[i].id != id) i = (i + 1) & mask;
+        slots[i].handle = handle;
+    }
+
+    /*
+    * Shrink the table, never below the size it started with, to the smallest that is at most a quarter
+    * full - so it takes twice as many ids again before the next growth. Does nothing unless that at
+    * least halves it.
+    */
+    void shrink_to_fit() {
+        size_t capacity = min_capacity;
+        while (capacity < 4 * count) capacity *= 2;
+        if (capacity < slots.size()) resize(capacity);
+    }
+
+    size_t size() const { return count; }
+
+    // Slots of the table; their bytes are the index's footprint.
+    size_t capacity() const { return slots.size(); }
+    size_t bytes() const { return slots.size() * sizeof(Slot); }
+
+private:
+    struct Slot {
+        OrderId     id     = INVALID_ORDER_ID;
+        OrderHandle handle = NULL_ORDER;
+    };
+
+    vector<Slot> slots;
+    size_t mask         = 0;
+    size_t shift        = 0;
+    size_t count        = 0;
+    size_t min_capacity = 16;
+
+    // Fibonacci hashing - spreads the sequential ids the book assigns over the whole table.
+    size_t slot_of(OrderId id) const {
+        return static_cast<size_t>((id * 0x9E3779B97F4A7C15ull) >> shift);
+    }
+
+    void place(OrderId id, OrderHandle handle) {
+        size_t i = slot_of(id);
+        while (slots[i].id != INVALID_ORDER_ID) i = (i + 1) & mask;
+        slots[i] = Slot{id, handle};
+    }
+
+    void resize(size_t capacity) {
+        vector<Slot> old(capacity);
+        old.swap(slots);
+        mask  = capacity - 1;
+        shift = 64 - countr_zero(capacity);
+        for (const Slot& slot : old) {
+            if (slot.id != INVALID_ORDER_ID) place(slot.id, slot.handle);
+        }
+    }
+};
@@ -0,0 +1,96 @@
+/*
+* Validating parser for text order entry.
+*
+* Turns the <Side> <Quantity> <Price> fields of an order straight into integers - the quantity
+* and the price in units of the tick size's precision - in a single pass over each field.
+* No regex and no float round trip.
+*
+* Usage:
+*   ParsedOrder order;
+*   if (parse_order('B', "50", "10.39", DEFAULT_TICK_SIZE, order) == ValidationResult::VALID)
+*       // order.price == 10390
+*/
+
+#pragma once
+
+#include "order_request.hpp"
+#include "price.hpp"
+#include <cstddef>
+#include <span>
+#include <string>
+#include <string_view>
+using namespace std;
+
+// Why an order or request was accepted or rejected, by the parser, a book or its risk checks.
+enum class ValidationResult {
+    // Raised by the parser and validate_order.
+    VALID,
+    INVALID_SIDE,
+    INVALID_QUANTITY,
+    INVALID_PRICE,
+    // Only raised by books with a bounded price range (see PriceLadderBook) or 32-bit prices (see OrderBook32).
+    PRICE_OUT_OF_RANGE,
+    // A caller-chosen order id that is already resting in the book.
+    DUPLICATE_ORDER_ID,
+    // A post-only order that would have traded on arrival.
+    WOULD_CROSS,
+    // A fill-or-kill order that could not have been filled in full.
+    INSUFFICIENT_LIQUIDITY,
+    // Raised by the pre-trade risk checks of a book with a RiskChecker (see risk_checker.hpp).
+    UNKNOWN_ACCOUNT,
+    ORDER_QUANTITY_LIMIT,
+    NOTIONAL_LIMIT,
+    EXPOSURE_LIMIT,
+    // A cancel or modify of an id that is not resting in the book.
+    UNKNOWN_ORDER_ID,
+    // An order or modify a book with 32-bit quantities cannot store, alone or in the total of its level.
+    QUANTITY_OUT_OF_RANGE
+};
+
+// An order as decoded from text. The price here is scaled to 10^-decimals units of the tick size.
+struct ParsedOrder {
+    char     side;
+    Quantity quantity;
+    Price    price;
+};
+
+/*
+* @brief
+* Validate the fields of an order and convert them to integers.
+* Quantity must match ^[1-9][0-9]*$ and price must match ^[0-9]*\.?[0-9]+$ and be at least one tick.
+* Prices are truncated down to the tick size, values that do not fit in 64 bits are rejected.
+*
+* @param side:      'B' for buy or 'S' for sell.
+* @param quantity:  Order quantity as text.
+* @param price:     Order price as text.
+* @param tick_size: Precision and tick the price is converted to.
+* @param order:     Filled with the parsed order; only meaningful when VALID is returned.
+*
+* @return: VALID, or the first invalidity found in the order of side, quantity, price.
+*/
+ValidationResult parse_order(char side, string_view quantity, string_view price,
+                             const TickSize& tick_size, ParsedOrder& order);
+
+/*
+* Same checks as parse_order, for orders that are already in integer form (e.g. decoded from a binary feed).
+* A price that is not a multiple of the tick size is rejected rather than truncated. The price of a
+* MARKET order is ignored.
+*/
+ValidationResult validate_order(char side, Quantity quantity, Price price, const TickSize& tick_size,
+                                OrderType order_type = OrderType::LIMIT);
+
+// Requests validate_orders is called with at a time by the books' batch entry points.
+const size_t VALIDATION_BATCH = 512;
+
+/*
+* validate_order for every ADD of a batch, in one pass before any of them is matched. The loop has no
+* early exits or calls, so it stays a tight run over the requests. Cancels and modifies come out VALID.
+*
+* @param results: One result per request; at least requests.size() entries.
+*/
+void validate_orders(span<const OrderRequest> requests, const TickSize& tick_size, ValidationResult* results);
+
+/*
+* Returns a human-readable message corresponding to the input validation result.
+*/
+string input_validation_message(ValidationResult result, const TickSize& tick_size = DEFAULT_TICK_SIZE);
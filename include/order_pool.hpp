@@ -0,0 +1,211 @@
+/*
+* Slab pool of order nodes, shared by the order book implementations.
+*
+* Orders are allocated from chunks of CHUNK_SIZE nodes and recycled through a free list, so adding
+* and removing orders (and with them whole price levels) never reaches the global allocator once the
+* pool has grown to the working size of the book. Nodes are addressed by a 32-bit handle rather than
+* a pointer and carry the prev/next links of the intrusive FIFO of their price level.
+*
+* Each order is split in two parallel arrays indexed by the same handle: the hot OrderNode - id,
+* remaining quantity and links, 24 bytes - which is all that matching reads while it walks a level,
+* and the cold OrderInfo - side, price, sequence number, timestamp, original quantity, account - which only
+* cancel, modify and snapshots need, since side and price are implied by the level an order rests in.
+*
+* The pool grows to the most orders resting at once and keeps that size; shrink() moves the orders of the
+* last chunks down into free nodes and drops those chunks.
+*
+* The price and quantity of the two halves are stored as PriceT and QtyT, 64-bit by default (OrderPool). A book
+* for instruments whose prices and quantities fit in 32 bits uses BasicOrderPool<int32_t, int32_t>, whose
+* OrderInfo is 32 bytes instead of 40; the caller checks the range, the pool narrows without checking.
+*
+* Usage:
+*   OrderPool pool;
+*   OrderHandle handle = pool.allocate(1, 'B', 50, 10390, 1730764173, 1, DEFAULT_ACCOUNT);
+*   pool[handle].quantity -= 10;
+*   pool.info(handle).price;                           // 10390
+*   pool.release(handle);
+*/
+
+#pragma once
+
+#include "price.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+using namespace std;
+
+// Identifier of an order, assigned by the book when the order is accepted. 0 is never assigned.
+using OrderId = uint64_t;
+const OrderId INVALID_ORDER_ID = 0;
+
+// Account an order is entered for, an index into the per-account arrays of a RiskChecker.
+using AccountId = uint32_t;
+const AccountId DEFAULT_ACCOUNT = 0;
+
+// Index of an order node in its OrderPool.
+using OrderHandle = uint32_t;
+const OrderHandle NULL_ORDER = UINT32_MAX;
+
+// The part of an order that matching reads: who it is, what is left of it, and its links in the FIFO of its price level.
+template <class QtyT = Quantity>
+struct BasicOrderNode {
+    OrderId     id       = INVALID_ORDER_ID;
+    QtyT        quantity = 0;
+    OrderHandle prev     = NULL_ORDER;
+    OrderHandle next     = NULL_ORDER;
+};
+
+// The rest of an order, kept apart from its node. Note that the price here is scaled (see price.hpp) and hence an integer.
+// The 64-bit fields come first so that 32-bit prices and quantities pack without padding.
+template <class PriceT = Price, class QtyT = Quantity>
+struct BasicOrderInfo {
+    long      timestamp         = 0; // Wall-clock metadata from the caller; plays no part in priority.
+    uint64_t  sequence          = 0; // Given by the book when the order joined the back of its level: lower is ahead.
+    PriceT    price             = 0;
+    QtyT      original_quantity = 0; // Quantity the order rested with.
+    AccountId account           = DEFAULT_ACCOUNT;
+    char      side              = 0;
+};
+
+using OrderNode = BasicOrderNode<>;
+using OrderInfo = BasicOrderInfo<>;
+
+static_assert(sizeof(OrderNode) == 24, "OrderNode is the unit of a level walk - keep it small");
+static_assert(sizeof(BasicOrderInfo<int32_t, int32_t>) == 32, "32-bit prices and quantities should pack the cold half");
+
+template <class PriceT = Price, class QtyT = Quantity>
+class BasicOrderPool {
+public:
+    // Nodes per chunk - a power of two so a handle splits into chunk and offset with a shift and a mask.
+    static constexpr size_t CHUNK_BITS = 12;
+    static constexpr size_t CHUNK_SIZE = size_t(1) << CHUNK_BITS;
+
+    /*
+    * @param initial_capacity: Nodes to allocate up front, rounded up to whole chunks.
+    */
+    explicit BasicOrderPool(size_t initial_capacity = CHUNK_SIZE) {
+        while (capacity() < initial_capacity) grow();
+    }
+
+    BasicOrderPool(const BasicOrderPool&)            = delete;
+    BasicOrderPool& operator=(const BasicOrderPool&) = delete;
+
+    using Node = BasicOrderNode<QtyT>;
+    using Info = BasicOrderInfo<PriceT, QtyT>;
+
+    Node&       operator[](OrderHandle handle)       { return chunks[handle >> CHUNK_BITS][handle & (CHUNK_SIZE - 1)]; }
+    const Node& operator[](OrderHandle handle) const { return chunks[handle >> CHUNK_BITS][handle & (CHUNK_SIZE - 1)]; }
+
+    Info&       info(OrderHandle handle)       { return info_chunks[handle >> CHUNK_BITS][handle & (CHUNK_SIZE - 1)]; }
+    const Info& info(OrderHandle handle) const { return info_chunks[handle >> CHUNK_BITS][handle & (CHUNK_SIZE - 1)]; }
+
+    // Take a node off the free list (growing by one chunk if none is left) and initialize both halves of the order.
+    OrderHandle allocate(OrderId id, char side, Quantity quantity, Price price, long timestamp, uint64_t sequence,
+                         AccountId account) {
+        if (free_head == NULL_ORDER) grow();
+
+        OrderHandle handle = free_head;
+        Node&       node   = (*this)[handle];
+        free_head = node.next;
+
+        node         = Node{id, static_cast<QtyT>(quantity), NULL_ORDER, NULL_ORDER};
+        info(handle) = Info{timestamp, sequence, static_cast<PriceT>(price), static_cast<QtyT>(quantity), account, side};
+
+        if (++in_use > high_water) high_water = in_use;
+        return handle;
+    }
+
+    // Return a node to the free list. The node must not be linked in any level.
+    void release(OrderHandle handle) {
+        (*this)[handle].next = free_head;
+        free_head = handle;
+        in_use--;
+    }
+
+    // Return a chain of count nodes, linked by next from first to last, to the free list in one step.
+    void release_chain(OrderHandle first, OrderHandle last, size_t count) {
+        (*this)[last].next = free_head;
+        free_head = first;
+        in_use -= count;
+    }
+
+    // Nodes currently allocated.
+    size_t size() const { return in_use; }
+
+    // Nodes allocated or free, i.e. the pool's footprint in nodes.
+    size_t capacity() const { return chunks.size() * CHUNK_SIZE; }
+
+    // Most nodes ever allocated at the same time.
+    size_t high_water_mark() const { return high_water; }
+
+    // Bytes per node, both halves.
+    static constexpr size_t NODE_BYTES = sizeof(Node) + sizeof(Info);
+
+    size_t chunk_count() const { return chunks.size(); }
+
+    /*
+    * @brief
+    * Drop the chunks after the first keep_chunks, moving the nodes in use in them to free nodes of the
+    * chunks kept. After each move moved(to) is called with the node's new handle, to repoint whatever
+    * still refers to the old one: its neighbours' links, its level's head or tail, the order index.
+    * Walks the free list once and the dropped chunks once.
+    *
+    * @return: number of chunks dropped; 0 if keep_chunks cannot hold the nodes in use.
+    */
+    template <class Moved>
+    size_t shrink(size_t keep_chunks, Moved&& moved) {
+        if (keep_chunks >= chunks.size() || keep_chunks * CHUNK_SIZE < in_use) return 0;
+        OrderHandle base = static_cast<OrderHandle>(keep_chunks * CHUNK_SIZE);
+
+        // Split the free list: free nodes below base stay on it in order, those above are only marked.
+        vector<bool> free_above(capacity() - base, false);
+        OrderHandle* link = &free_head;
+        for (OrderHandle handle = free_head; handle != NULL_ORDER; handle = (*this)[handle].next) {
+            if (handle >= base) {
+                free_above[handle - base] = true;
+                continue;
+            }
+            *link = handle;
+            link  = &(*this)[handle].next;
+        }
+        *link = NULL_ORDER;
+
+        for (OrderHandle from = base; from < capacity(); from++) {
+            if (free_above[from - base]) continue;
+            OrderHandle to = free_head;
+            free_head      = (*this)[to].next;
+            (*this)[to]    = (*this)[from];
+            info(to)       = info(from);
+            moved(to);
+        }
+
+        size_t dropped = chunks.size() - keep_chunks;
+        chunks.resize(keep_chunks);
+        info_chunks.resize(keep_chunks);
+        chunks.shrink_to_fit();
+        info_chunks.shrink_to_fit();
+        return dropped;
+    }
+
+private:
+    vector<unique_ptr<Node[]>> chunks;
+    vector<unique_ptr<Info[]>> info_chunks; // Parallel to chunks.
+    OrderHandle free_head  = NULL_ORDER;
+    size_t      in_use     = 0;
+    size_t      high_water = 0;
+
+    // Add a chunk and thread its nodes onto the free list, lowest handle first.
+    void grow() {
+        OrderHandle base = static_cast<OrderHandle>(capacity());
+        chunks.emplace_back(make_unique<Node[]>(CHUNK_SIZE));
+        info_chunks.emplace_back(make_unique<Info[]>(CHUNK_SIZE));
+        Node* chunk = chunks.back().get();
+        for (size_t i = 0; i < CHUNK_SIZE; i++)
+            chunk[i].next = i + 1 < CHUNK_SIZE ? base + static_cast<OrderHandle>(i + 1) : free_head;
+        free_head = base;
+    }
+};
+
+// The pool of books that store 64-bit prices and quantities.
+using OrderPool = BasicOrderPool<>;
@@ -0,0 +1,48 @@
+/*
+* Fixed-width binary order records, and a view of a memory-mapped file as an array of them.
+*
+* A day file is just an array of OrderRecords in the byte order of the machine that wrote it, with
+* no header. Prices are already scaled by the tick size of the book that replays them, so a replay
+* feeds each record straight into the parsed-integer add_order without any text parsing.
+*
+* Usage:
+*   MappedOrderFile file;
+*   if (!file.open("orders.bin")) ...
+*   for (const OrderRecord& record : file.records())
+*       order_book.add_order(record.side, record.quantity, record.price, record.timestamp, record.id);
+*/
+
+#pragma once
+
+#include "mapped_file.hpp"
+#include "order_pool.hpp"
+#include "price.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <type_traits>
+using namespace std;
+
+struct OrderRecord {
+    OrderId  id;        // INVALID_ORDER_ID to let the book assign one.
+    Quantity quantity;
+    Price    price;     // In 10^-decimals units of the replaying book's tick size.
+    int64_t  timestamp;
+    char      side;     // 'B' or 'S'.
+    char      padding[3];
+    AccountId account;  // DEFAULT_ACCOUNT in files written before accounts existed (the bytes were padding).
+};
+
+static_assert(sizeof(OrderRecord) == 40 && is_trivially_copyable_v<OrderRecord>, "OrderRecord is a wire format");
+
+class MappedOrderFile : public MappedFile {
+    /*
+    * A mapped file viewed as OrderRecords. A trailing partial record is ignored.
+    */
+
+public:
+    span<const OrderRecord> records() const {
+        return {reinterpret_cast<const OrderRecord*>(bytes().data()), bytes().size() / sizeof(OrderRecord)};
+    }
+};
@@ -0,0 +1,56 @@
+/*
+* A request to an order book - add, cancel or modify - in already-parsed integer form.
+*
+* This is what travels between threads and through queues, so it is a small trivially copyable struct.
+*
+* Usage:
+*   order_book.submit(OrderRequest::add('B', 50, 10390, 1730764173));
+*   order_book.submit(OrderRequest::add('S', 20, 10380, 1730764174, INVALID_ORDER_ID, OrderType::IOC));
+*   order_book.submit(OrderRequest::cancel(42));
+*/
+
+#pragma once
+
+#include "order_pool.hpp"
+#include "price.hpp"
+using namespace std;
+
+enum class RequestType : char {
+    ADD,
+    CANCEL,
+    MODIFY
+};
+
+// How an add is matched, and whether what is left of it rests.
+enum class OrderType : char {
+    LIMIT,      // Match up to the price, rest the remainder.
+    MARKET,     // Match at any price, drop the remainder. The price is ignored.
+    IOC,        // Immediate-or-cancel: match up to the price, drop the remainder.
+    FOK,        // Fill-or-kill: fill in full up to the price, or reject without trading.
+    POST_ONLY   // Rest without trading, or reject if the order would trade on arrival.
+};
+
+struct OrderRequest {
+    RequestType type;
+    char        side;       // ADD only.
+    OrderType   order_type; // ADD only.
+    AccountId   account;    // ADD only.
+    Quantity    quantity;   // ADD, and the new quantity for MODIFY.
+    Price       price;      // ADD only, in 10^-decimals units of the book's tick size.
+    long        timestamp;  // ADD only.
+    OrderId     id;         // Order to cancel or modify. For ADD, an id chosen by the caller, or INVALID_ORDER_ID
+                            // to let the book assign the next one.
+
+    static OrderRequest add(char side, Quantity quantity, Price price, long timestamp, OrderId id = INVALID_ORDER_ID,
+                            OrderType order_type = OrderType::LIMIT, AccountId account = DEFAULT_ACCOUNT) {
+        return OrderRequest{RequestType::ADD, side, order_type, account, quantity, price, timestamp, id};
+    }
+
+    static OrderRequest cancel(OrderId id) {
+        return OrderRequest{RequestType::CANCEL, 0, OrderType::LIMIT, DEFAULT_ACCOUNT, 0, 0, 0, id};
+    }
+
+    static OrderRequest modify(OrderId id, Quantity quantity) {
+        return OrderRequest{RequestType::MODIFY, 0, OrderType::LIMIT, DEFAULT_ACCOUNT, quantity, 0, 0, id};
+    }
+};
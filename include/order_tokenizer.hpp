@@ -0,0 +1,65 @@
+/*
+* Bulk tokenizer for text order files, turning a whole buffer of "<Side> <Quantity> <Price>" lines
+* into a column-oriented batch of parsed orders.
+*
+* Notes:
+*   - One order per line. Fields are separated by any run of spaces, tabs or commas, so both the
+*     format typed into app/market_engine.cpp and simple CSV are accepted; "\r\n" line ends are fine.
+*   - Delimiters and newlines are found 64 bytes at a time as bitmasks (AVX2 or SSE2 when the build
+*     targets them, a scalar loop otherwise), and quantity and price digits are converted 8 at a time
+*     with SWAR arithmetic. Fields that do not fit the fast path go through parse_order, so every row
+*     gets exactly the result parse_order would give it.
+*   - Blank lines are skipped. Lines without exactly three fields are counted as malformed and dropped.
+*
+* Usage:
+*   OrderColumns orders;
+*   tokenize_orders(file.bytes(), DEFAULT_TICK_SIZE, orders);
+*   order_book.add_orders(orders, 1);
+*/
+
+#pragma once
+
+#include "order_parser.hpp"
+#include "price.hpp"
+#include <cstddef>
+#include <string_view>
+#include <vector>
+using namespace std;
+
+// Parsed orders, one vector per field, index i of each being row i.
+struct OrderColumns {
+    vector<char>             sides;
+    vector<Quantity>         quantities;
+    vector<Price>            prices;
+    vector<ValidationResult> results;         // What parse_order returned for the row.
+    size_t                   malformed_lines = 0;
+
+    size_t size() const { return sides.size(); }
+
+    void clear() {
+        sides.clear();
+        quantities.clear();
+        prices.clear();
+        results.clear();
+        malformed_lines = 0;
+    }
+
+    void reserve(size_t rows) {
+        sides.reserve(rows);
+        quantities.reserve(rows);
+        prices.reserve(rows);
+        results.reserve(rows);
+    }
+};
+
+/*
+* @brief
+* Parse every line of a buffer and append one row per order line to the batch.
+*
+* @param text:      Whole lines; a last line without a newline is parsed too.
+* @param tick_size: Tick size prices are scaled and truncated to, as in parse_order.
+* @param orders:    Batch the rows are appended to.
+*
+* @return: number of rows appended.
+*/
+size_t tokenize_orders(string_view text, const TickSize& tick_size, OrderColumns& orders);
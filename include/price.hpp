@@ -0,0 +1,66 @@
+/*
+* Integer price representation shared by the order books.
+*
+* Prices are never held as floats. A price is an integer count of 10^-decimals units, e.g. with
+* 3 decimals 10.234 is stored as 10234. The tick size is a whole number of those units and every
+* price in the book is a multiple of it, so equal prices always land on the same level.
+*
+* Usage:
+*   TickSize tick{2, 5};                // 0.05 ticks, prices held in cents
+*   format_price(1045, tick);           // "10.45"
+*   char text[PRICE_CHARS];
+*   char* end = format_price_to(text, 1045, tick);
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+using namespace std;
+
+// 64 bits regardless of platform - prices above a few thousand at fine ticks overflow 32 bits.
+using Price    = int64_t;
+using Quantity = int64_t;
+
+// Decimal places beyond this would overflow the 10^decimals scale of a 64-bit price.
+const int MAX_PRICE_DECIMALS = 9;
+
+struct TickSize {
+    int   decimals; // Price precision - number of decimal places kept.
+    Price units;    // Tick size in units of 10^-decimals.
+
+    // 10^decimals, i.e. the number of price units in 1.0
+    constexpr Price scale() const {
+        Price s = 1;
+        for (int i = 0; i < decimals; i++) s *= 10;
+        return s;
+    }
+
+    constexpr bool is_valid() const {
+        return decimals >= 0 && decimals <= MAX_PRICE_DECIMALS && units > 0;
+    }
+
+    // Truncate a price to the tick at or below it.
+    constexpr Price round_down(Price price) const {
+        return price - price % units;
+    }
+};
+
+// Most characters format_price_to writes: sign, 19 digits, '.' and MAX_PRICE_DECIMALS fraction digits, rounded up.
+const size_t PRICE_CHARS = 32;
+
+// A tick size of 0.001 - the default precision of the engine.
+constexpr TickSize DEFAULT_TICK_SIZE{3, 1};
+
+/*
+* Format a price as a decimal number, dropping trailing zeros in the fraction (10.5 rather than 10.500,
+* 10 rather than 10.000).
+*/
+string format_price(Price price, const TickSize& tick_size);
+
+/*
+* Same as format_price, written to a buffer of at least PRICE_CHARS characters without allocating.
+*
+* @return: The end of the characters written. No terminating null is written.
+*/
+char* format_price_to(char* out, Price price, const TickSize& tick_size);
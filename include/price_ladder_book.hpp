@@ -0,0 +1,292 @@
+/*
+* Defines the PriceLadderBook class - an order book for instruments that trade in a bounded price range.
+*
+* Same interface and price-time priority matching as OrderBook, but price levels live in a contiguous
+* array indexed by (price - min_price) / tick instead of in ordered maps. best bid/ask are cached and
+* recovered through a hierarchical bitmap of non-empty levels when the best level empties. Like
+* OrderBook it is a template over its match policy; PriceLadderBook is the price-time one.
+*
+* Usage:
+*   PriceLadderBook order_book(9000, 11000);              // Prices 9.000 to 11.000 at a 0.001 tick
+*   order_book.add_order('B', "50", "10.39", 1730764173);
+*/
+
+#pragma once
+
+#include "book_display.hpp"
+#include "book_stats.hpp"
+#include "depth_cache.hpp"
+#include "event_sink.hpp"
+#include "match_policy.hpp"
+#include "level_bitmap.hpp"
+#include "order_index.hpp"
+#include "order_parser.hpp"
+#include "order_pool.hpp"
+#include "order_record.hpp"
+#include "order_request.hpp"
+#include "order_tokenizer.hpp"
+#include "price.hpp"
+#include "price_level.hpp"
+#include "risk_checker.hpp"
+#include "volume_tree.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <vector>
+using namespace std;
+
+template <class Policy = PriceTimePolicy>
+class BasicPriceLadderBook {
+    /*
+    * Maintains an Exchange Order Book over a fixed price range and provides the following functionalities:
+    * - Add a new order (side, quantity, price, timestamp)
+    * - Cancel or modify a resting order by the id add_order returned
+    * - Match each incoming order against the opposite side as it is added (and publish the trades to an EventSink)
+    * - Print Order Book status
+    *
+    * Data structure used:
+    *  - A vector of price levels per side, one slot per tick in [min_price, max_price]. Each level
+    *    holds the queue of unmatched orders at that price and their total volume.
+    *  - A hierarchical bitmap per side marking the non-empty levels.
+    *  - The index of the best bid and best ask, so top of book is a plain read.
+    *  - Orders are nodes of an OrderPool linked into their level's queue, found by id through an OrderIndex.
+    *
+    * Memory is proportional to the width of the price range, not to the number of orders - this
+    * engine is meant for instruments that trade in a narrow band.
+    */
+
+private:
+    // Precision and tick of every price in this book.
+    TickSize tick_size;
+
+    // Where trades and all other book events go. Defaults to printing_sink.
+    PrintingSink printing_sink;
+    EventSink*   sink;
+
+    // Pre-trade limits and open quantity per account, if any (see set_risk).
+    RiskChecker* risk = nullptr;
+
+    // Lowest and highest price accepted, both multiples of the tick.
+    Price min_price;
+    Price max_price;
+
+    // Storage for all resting orders, and the index from their id to their node.
+    OrderPool  order_pool;
+    OrderIndex order_index;
+
+    // Id given to the next accepted order.
+    OrderId next_order_id = 1;
+
+    // Sequence number given to the next order that joins the back of a level. Priority within a level
+    // follows it, never the caller's timestamps.
+    uint64_t next_sequence = 1;
+
+    // Price levels indexed by (price - min_price) / tick, for each side.
+    vector<PriceLevel> buy_levels;
+    vector<PriceLevel> sell_levels;
+
+    // Non-empty levels of each side.
+    LevelBitmap buy_bitmap;
+    LevelBitmap sell_bitmap;
+
+    // Prefix sums of the level volumes of each side, for fill-or-kill checks.
+    VolumeTree buy_volumes;
+    VolumeTree sell_volumes;
+
+    // Index of the highest bid and the lowest ask, LevelBitmap::npos when that side is empty.
+    size_t best_buy_index  = LevelBitmap::npos;
+    size_t best_sell_index = LevelBitmap::npos;
+
+    size_t level_index(Price price) const { return static_cast<size_t>((price - min_price) / tick_size.units); }
+    Price  level_price(size_t index) const { return min_price + static_cast<Price>(index) * tick_size.units; }
+
+    // Best levels of each side, patched on every level update (see depth_cache.hpp).
+    DepthCache depth_cache;
+
+    // Frame buffer of print_order_book, kept between calls.
+    BookRenderer renderer;
+
+    // Latency histograms and matching counters; empty unless built with MARKET_ENGINE_INSTRUMENT.
+    [[no_unique_address]] BookInstrumentation instrumentation;
+
+    // Publish the new total volume of a level and keep the depth cache in step. Called wherever a total changes.
+    void level_updated(char side, Price price, Quantity total_volume) {
+        depth_cache.update(side, price, total_volume);
+        (side == 'B' ? buy_volumes : sell_volumes).set(level_index(price), total_volume);
+        if (total_volume == 0) instrumentation.level_destroyed(side);
+        sink->on_book_update(BookUpdateEvent{side, price, total_volume});
+    }
+
+    // Each level is filled by the match policy, which works on the members above.
+    template <class> friend struct LevelFill;
+
+    /*
+    * Match an incoming order against the opposite side, best price first, for as long as it crosses.
+    * Each level is filled as the match policy says (see match_policy.hpp). Returns the quantity left to
+    * rest in the book.
+    */
+    Quantity match(OrderId id, char side, AccountId account, Quantity quantity, Price price);
+
+    // add_order after validate_order: rejects or matches and rests the order, without flushing the sink.
+    OrderId accept_order(char side, Quantity quantity, Price price, long timestamp, OrderId id, OrderType order_type,
+                         AccountId account, ValidationResult validation_result);
+
+    // Whether an order at this price would trade against the opposite side on arrival.
+    bool crosses(char side, Price price) const;
+
+    // Whether the opposite side holds at least quantity at prices an order at this price would trade at.
+    // One prefix sum over the volume tree of that side, whatever the number of levels.
+    bool can_fill(char side, Quantity quantity, Price price);
+
+    // cancel_order and modify_order without flushing the sink.
+    bool remove_order(OrderId id);
+    ValidationResult amend_order(OrderId id, Quantity new_quantity);
+
+public:
+    /*
+    * @param min_price: Lowest price accepted, in 10^-decimals units of the tick size. Rounded down to the tick.
+    * @param max_price: Highest price accepted, in 10^-decimals units of the tick size. Rounded down to the tick.
+    * @param tick_size: Precision and tick size of prices.
+    * @param sink:      Receives trades and other book events; nullptr prints trades and rejections to cout.
+    */
+    BasicPriceLadderBook(Price min_price, Price max_price, TickSize tick_size = DEFAULT_TICK_SIZE, EventSink* sink = nullptr);
+
+    /*
+    * @brief
+    * Create a new Order with the given price, quantity and timestamp and match it, as OrderBook::add_order.
+    * Orders priced outside [min_price, max_price] are rejected with PRICE_OUT_OF_RANGE.
+    *
+    * @return: id of the new order, or INVALID_ORDER_ID if it was rejected.
+    */
+    OrderId add_order(char side, string_view quantity_str, string_view price_str, long timestamp);
+
+    /*
+    * Same as above for an order that is already parsed, e.g. decoded from a binary feed. The id may be
+    * chosen by the caller, and the order may be of any OrderType and account, as OrderBook::add_order. A MARKET
+    * order sweeps up to the end of the ladder.
+    */
+    OrderId add_order(char side, Quantity quantity, Price price, long timestamp = 0, OrderId id = INVALID_ORDER_ID,
+                      OrderType order_type = OrderType::LIMIT, AccountId account = DEFAULT_ACCOUNT);
+
+    /*
+    * Apply an add, cancel or modify request, as OrderBook::submit.
+    */
+    OrderId submit(const OrderRequest& request);
+
+    /*
+    * Apply a burst of requests in arrival order with a single flush, as OrderBook::add_orders.
+    */
+    size_t add_orders(span<const OrderRequest> requests, span<OrderId> ids = {});
+
+    /*
+    * Apply a column batch of new orders from tokenize_orders with a single flush, as OrderBook::add_orders.
+    */
+    size_t add_orders(const OrderColumns& orders, long first_timestamp, span<OrderId> ids = {});
+
+    /*
+    * @brief
+    * Remove a resting order from the book. The order is found through the id index, no level is scanned.
+    *
+    * @return: true if the order was resting and is now cancelled, false if the id is unknown or already filled.
+    */
+    bool cancel_order(OrderId id);
+
+    /*
+    * @brief
+    * Change the remaining quantity of a resting order. Reducing the quantity keeps the order's time
+    * priority; increasing it moves the order to the back of its price level.
+    *
+    * @return: VALID if the order was amended; UNKNOWN_ORDER_ID if the id is not resting; INVALID_QUANTITY if
+    * new_quantity is not positive; or, for an increase, the limit of the order's account it would break -
+    * ORDER_QUANTITY_LIMIT, NOTIONAL_LIMIT or EXPOSURE_LIMIT (see set_risk), which is also published to the
+    * sink as a RejectEvent.
+    */
+    ValidationResult modify_order(OrderId id, Quantity new_quantity);
+
+    /*
+    * Print the current state of the order book i.e only the unmatched orders, highest bid and lowest ask first.
+    * The frame is built in a reused buffer and written with one write.
+    *
+    * @param max_levels: Rows to print, i.e. levels per side; the default prints every level.
+    */
+    void print_order_book(size_t max_levels = SIZE_MAX);
+
+    /*
+    * Best bid and best ask with their total volume, read straight off the ends of the book.
+    */
+    TopOfBook top_of_book() const;
+
+    /*
+    * @brief
+    * The best levels of each side. Served from the incrementally kept depth cache; a side is only
+    * re-read from the book - its first MAX_DEPTH levels - if a top level was removed since the last call.
+    *
+    * @param levels: Levels per side wanted, at most MAX_DEPTH.
+    */
+    DepthSnapshot depth(size_t levels = MAX_DEPTH);
+
+    // Precision and tick of every price in this book.
+    TickSize tick() const { return tick_size; }
+
+    /*
+    * Id the next order the book accepts will get, unless the caller chooses one.
+    */
+    OrderId next_id() const { return next_order_id; }
+
+    /*
+    * Send all further events to another sink, e.g. to restore a book silently; nullptr prints them to cout.
+    */
+    void set_sink(EventSink* new_sink) { sink = new_sink ? new_sink : &printing_sink; }
+
+    /*
+    * Check every further add against the limits of its account before it is matched, and keep the
+    * accounts' open quantities in risk; nullptr turns the checks off. Attach it before any order rests.
+    */
+    void set_risk(RiskChecker* new_risk) { risk = new_risk; }
+
+    /*
+    * @brief
+    * Append every resting order to orders - buys then sells, each side in ascending price order and each
+    * level in time priority - in the form restore() takes back.
+    */
+    void export_orders(vector<OrderRecord>& orders) const;
+
+    /*
+    * @brief
+    * Bulk-load resting orders into an empty book, e.g. from a snapshot. The orders are linked straight into
+    * their levels with no matching and no events, and keep their ids, timestamps and time priority.
+    *
+    * @param orders:        Resting orders in the order export_orders writes them.
+    * @param next_order_id: Id the next order will get (raised past the largest id restored if needed).
+    *                       Restored orders get fresh sequence numbers in the order given.
+    *
+    * @return: false, with the book left unchanged, if the book is not empty or an order is invalid for it
+    *          (side, quantity, price outside the book, or a duplicate id).
+    */
+    bool restore(span<const OrderRecord> orders, OrderId next_order_id);
+
+    /*
+    * Most orders resting in the book at the same time - the size the order pool had to grow to.
+    */
+    size_t order_pool_high_water_mark() const { return order_pool.high_water_mark(); }
+
+    /*
+    * Snapshot of the latency histograms and counters (see book_stats.hpp). All zero unless the book
+    * was built with MARKET_ENGINE_INSTRUMENT.
+    */
+    BookStats stats() const { return instrumentation.stats(); }
+};
+
+// Price-time priority, the book used throughout.
+using PriceLadderBook = BasicPriceLadderBook<>;
+
+// The match policies the library is built with (see the end of the .cpp).
+extern template class BasicPriceLadderBook<PriceTimePolicy>;
+extern template class BasicPriceLadderBook<MatchPolicy<SelfTradePrevention::CANCEL_NEWEST>>;
+extern template class BasicPriceLadderBook<MatchPolicy<SelfTradePrevention::CANCEL_OLDEST>>;
+extern template class BasicPriceLadderBook<MatchPolicy<SelfTradePrevention::DECREMENT>>;
+extern template class BasicPriceLadderBook<MatchPolicy<SelfTradePrevention::NONE, ProRataAllocation>>;
+extern template class BasicPriceLadderBook<MatchPolicy<SelfTradePrevention::CANCEL_NEWEST, ProRataAllocation>>;
+extern template class BasicPriceLadderBook<MatchPolicy<SelfTradePrevention::CANCEL_OLDEST, ProRataAllocation>>;
+extern template class BasicPriceLadderBook<MatchPolicy<SelfTradePrevention::DECREMENT, ProRataAllocation>>;
@@ -0,0 +1,76 @@
+/*
+* The price levels that queue orders, shared by the order book implementations.
+*
+* A level is an intrusive doubly-linked FIFO over nodes of an OrderPool plus the cached total volume
+* of its orders. It owns no memory itself, so creating and dropping levels costs no allocation. The
+* total is kept as QtyT, the quantity type of the pool's nodes (see BasicOrderPool).
+*/
+
+#pragma once
+
+#include "order_pool.hpp"
+#include "price.hpp"
+using namespace std;
+
+// All unmatched orders at one price, in time priority, along with their total volume.
+template <class QtyT = Quantity>
+struct BasicPriceLevel {
+    OrderHandle head = NULL_ORDER;
+    OrderHandle tail = NULL_ORDER;
+    QtyT        total_volume = 0;
+
+    bool empty() const { return head == NULL_ORDER; }
+
+    // Append an allocated order to the back of the queue.
+    template <class Pool>
+    void push_back(Pool& pool, OrderHandle handle) {
+        auto& node = pool[handle];
+        node.prev = tail;
+        node.next = NULL_ORDER;
+        if (tail == NULL_ORDER) head = handle;
+        else                    pool[tail].next = handle;
+        tail = handle;
+        total_volume += node.quantity;
+    }
+
+    // Unlink the order at the front of the queue and return it to the pool. Its quantity must already
+    // be taken out of total_volume (filled orders have none left).
+    template <class Pool>
+    void pop_front(Pool& pool) {
+        OrderHandle handle = head;
+        head = pool[handle].next;
+        if (head == NULL_ORDER) tail = NULL_ORDER;
+        else                    pool[head].prev = NULL_ORDER;
+        pool.release(handle);
+    }
+
+    // Drop every order of the queue at once and return the count nodes it holds to the pool. The FIFO
+    // is already linked through next, so it goes onto the free list as-is without visiting each node.
+    template <class Pool>
+    void clear(Pool& pool, size_t count) {
+        if (empty()) return;
+        pool.release_chain(head, tail, count);
+        head = tail  = NULL_ORDER;
+        total_volume = 0;
+    }
+
+    // Unlink any order of the queue, take its remaining quantity out of total_volume and return it to the pool.
+    template <class Pool>
+    void remove(Pool& pool, OrderHandle handle) {
+        unlink(pool, handle);
+        pool.release(handle);
+    }
+
+    // Unlink an order without releasing it, so it can be queued again (see push_back).
+    template <class Pool>
+    void unlink(Pool& pool, OrderHandle handle) {
+        auto& node = pool[handle];
+        if (node.prev == NULL_ORDER) head = node.next;
+        else                         pool[node.prev].next = node.next;
+        if (node.next == NULL_ORDER) tail = node.prev;
+        else                         pool[node.next].prev = node.prev;
+        total_volume -= node.quantity;
+    }
+};
+
+using PriceLevel = BasicPriceLevel<>;
@@ -0,0 +1,126 @@
+/*
+* Pre-trade risk checks, run by the order books on every add before it is matched and on every modify
+* that raises an order's quantity.
+*
+* Each account has limits on the quantity and the notional (quantity x price) of a single order, and
+* on its open quantity - the total remaining quantity of its resting orders, counting the incoming
+* order as if it all rested. Accounts are small integers indexing one flat array: checking an order
+* touches one entry, with no hashing and no tree search. A book with a RiskChecker keeps the open
+* quantity of each account up to date as its orders rest, fill, are cancelled or change quantity.
+*
+* Notes:
+*   - Notional is in price units (10^-decimals of the book's tick size) times quantity. The price of
+*     a market order is not known before it trades, so a market order is held to its quantity and
+*     open quantity limits only.
+*   - A modify that raises a resting order's quantity is checked with can_amend: its new quantity against
+*     the order quantity and notional limits, its increase against the open quantity limit.
+*   - Attach the checker to a book before any order rests, so the open quantities start from zero.
+*
+* Usage:
+*   RiskChecker risk(1000);                          // Accounts 0..999, no limits
+*   risk.set_limits(7, AccountLimits{500, 5'000'000, 2000});
+*   order_book.set_risk(&risk);
+*   order_book.add_order('B', 600, 10390, 0, INVALID_ORDER_ID, OrderType::LIMIT, 7);  // Rejected: ORDER_QUANTITY_LIMIT
+*/
+
+#pragma once
+
+#include "order_parser.hpp"
+#include "order_pool.hpp"
+#include "order_request.hpp"
+#include "price.hpp"
+#include <cstddef>
+#include <limits>
+#include <vector>
+using namespace std;
+
+// Limits of one account. The defaults allow everything.
+struct AccountLimits {
+    Quantity max_order_quantity = numeric_limits<Quantity>::max(); // Largest quantity of one order.
+    Quantity max_order_notional = numeric_limits<Quantity>::max(); // Largest quantity x price of one order.
+    Quantity max_open_quantity  = numeric_limits<Quantity>::max(); // Largest total quantity resting at once.
+};
+
+class RiskChecker {
+    /*
+    * Limits and open quantity of accounts 0..accounts-1.
+    */
+
+public:
+    /*
+    * @param accounts: Number of accounts; ids at or above it are rejected as UNKNOWN_ACCOUNT.
+    * @param limits:   Limits every account starts with.
+    */
+    explicit RiskChecker(size_t accounts, AccountLimits limits = {}) : states(accounts, AccountState{limits, 0}) {}
+
+    void set_limits(AccountId account, const AccountLimits& limits) { states[account].limits = limits; }
+
+    const AccountLimits& limits(AccountId account) const { return states[account].limits; }
+
+    // Total remaining quantity of the account's resting orders.
+    Quantity open_quantity(AccountId account) const { return states[account].open_quantity; }
+
+    size_t accounts() const { return states.size(); }
+
+    /*
+    * @brief
+    * Check an incoming order against the limits of its account.
+    *
+    * @return: VALID, or the first limit the order breaks in the order unknown account, quantity,
+    * notional, open quantity.
+    */
+    ValidationResult check(AccountId account, Quantity quantity, Price price, OrderType order_type) const {
+        if (account >= states.size()) return ValidationResult::UNKNOWN_ACCOUNT;
+        return check_order(account, quantity, price, order_type, quantity);
+    }
+
+    /*
+    * @brief
+    * Check a modify that raises a resting order of the account to new_quantity. The new quantity is held
+    * to the order quantity and notional limits as if the order were new, and only the increase counts
+    * towards the open quantity - the rest of the order is already in it.
+    *
+    * @param price:      Limit price of the resting order.
+    * @param open_delta: new_quantity less the order's remaining quantity.
+    *
+    * @return: VALID, or the first limit the modify breaks in the order quantity, notional, open quantity.
+    */
+    ValidationResult can_amend(AccountId account, Quantity new_quantity, Price price, Quantity open_delta) const {
+        return check_order(account, new_quantity, price, OrderType::LIMIT, open_delta);
+    }
+
+    // Whether quantity more can rest for the account without going over its open quantity limit.
+    bool can_open(AccountId account, Quantity quantity) const {
+        const AccountState& state = states[account];
+        return quantity <= state.limits.max_open_quantity - state.open_quantity;
+    }
+
+    // An order of the account rested with quantity.
+    void opened(AccountId account, Quantity quantity) { states[account].open_quantity += quantity; }
+
+    // Quantity of a resting order of the account traded, was cancelled or was taken off by a modify.
+    void closed(AccountId account, Quantity quantity) { states[account].open_quantity -= quantity; }
+
+private:
+    struct AccountState {
+        AccountLimits limits;
+        Quantity      open_quantity;
+    };
+
+    vector<AccountState> states; // Indexed by account id.
+
+    // Limits of an order of quantity, open_delta of which would be added to the account's open quantity.
+    ValidationResult check_order(AccountId account, Quantity quantity, Price price, OrderType order_type,
+                                 Quantity open_delta) const {
+        const AccountState& state = states[account];
+        if (quantity > state.limits.max_order_quantity) return ValidationResult::ORDER_QUANTITY_LIMIT;
+
+        Quantity notional;
+        if (order_type != OrderType::MARKET &&
+            (__builtin_mul_overflow(quantity, price, &notional) || notional > state.limits.max_order_notional))
+            return ValidationResult::NOTIONAL_LIMIT;
+
+        if (!can_open(account, open_delta)) return ValidationResult::EXPOSURE_LIMIT;
+        return ValidationResult::VALID;
+    }
+};
@@ -0,0 +1,124 @@
+/*
+* Defines Sequencer, the front-end that lets many gateway threads feed one StockOrderBook.
+*
+* StockOrderBook::submit() is single producer. A Sequencer gives each producer thread - a TCP session,
+* a feed handler - a single-producer/single-consumer ring of its own, and runs one sequencer thread that
+* drains the rings round-robin, stamps every request with the next global sequence number (1, 2, 3, ...)
+* and routes it to the shard of its symbol. Producers never share a line that another producer writes,
+* so there is no mutex and no contended atomic on the ingest path: adding producers adds rings, and the
+* books behind the shards stay single-threaded.
+*
+* The sequence numbers give every request a place in one total order across producers and symbols.
+* Each shard processes its requests in that order, and StockOrderBook::last_sequence tells how far the
+* shard of a symbol has got.
+*
+* Notes:
+*   - submit(producer, ...) is single producer per ring: every producer index is used by one thread only.
+*   - Requests of one producer are sequenced in the order it submitted them; requests of different
+*     producers interleave in the order the sequencer finds them. Requests for unknown symbols are
+*     dropped without a sequence number.
+*   - The sequencer thread is the one producer of the StockOrderBook: do not call stocks.submit() while
+*     the sequencer runs.
+*
+* Usage:
+*   StockOrderBook stocks(4);
+*   SymbolId aapl = stocks.add_symbol("AAPL");
+*   Sequencer sequencer(stocks, 8);                  // 8 producer threads
+*   stocks.start();
+*   sequencer.start();
+*   sequencer.submit(3, aapl, OrderRequest::add('B', 50, 10390, 1730764173, 1));   // On producer 3's thread
+*   sequencer.wait_idle();
+*/
+
+#pragma once
+
+#include "order_request.hpp"
+#include "spsc_queue.hpp"
+#include "stock_order_book.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+using namespace std;
+
+// Requests the sequencer takes from one ring before moving on to the next.
+const size_t SEQUENCER_BATCH = 64;
+
+class Sequencer {
+    /*
+    * Merges the requests of producer threads into one sequenced stream for a StockOrderBook.
+    */
+
+private:
+    // A request as a producer hands it over.
+    struct GatewayRequest {
+        SymbolId     symbol;
+        OrderRequest request;
+    };
+
+    struct Producer {
+        SpscQueue<GatewayRequest> queue;
+        // Read by wait_idle(); on a line of its own, away from the ring's indexes.
+        alignas(CACHE_LINE_SIZE) atomic<uint64_t> submitted{0}; // Written by the producer only.
+
+        explicit Producer(size_t queue_capacity) : queue(queue_capacity) {}
+    };
+
+    StockOrderBook&              stocks;
+    vector<unique_ptr<Producer>> producers;
+    thread                       worker;
+    atomic<bool>                 running{false};
+
+    // Written by the sequencer thread only.
+    alignas(CACHE_LINE_SIZE) atomic<uint64_t> taken{0};         // Requests taken from the rings.
+    atomic<uint64_t>                          next_sequence{1};
+
+    void run();
+
+    // Take up to SEQUENCER_BATCH requests from one ring and route them. Returns how many it took.
+    size_t drain(Producer& producer);
+
+public:
+    /*
+    * @param stocks:         Books to feed. Started and stopped by the caller.
+    * @param producer_count: Number of producer threads, each with its own ring.
+    * @param queue_capacity: Requests each ring holds before submit() has to wait.
+    */
+    Sequencer(StockOrderBook& stocks, size_t producer_count, size_t queue_capacity = 4096);
+
+    ~Sequencer();
+
+    Sequencer(const Sequencer&)            = delete;
+    Sequencer& operator=(const Sequencer&) = delete;
+
+    size_t producer_count() const { return producers.size(); }
+
+    // Launch the sequencer thread.
+    void start();
+
+    // Sequence what is already in the rings, then join the sequencer thread. Also done by the destructor.
+    void stop();
+
+    /*
+    * @brief
+    * Queue a request from a producer. Waits while the producer's ring is full.
+    *
+    * @param producer: Index of the calling producer, below producer_count(). One thread per index.
+    * @param symbol:   Symbol of the book the request is for.
+    * @param request:  Add, cancel or modify request.
+    */
+    void submit(size_t producer, SymbolId symbol, const OrderRequest& request) {
+        Producer& ring = *producers[producer];
+        GatewayRequest entry{symbol, request};
+        while (!ring.queue.try_push(entry)) cpu_relax();
+        ring.submitted.store(ring.submitted.load(memory_order_relaxed) + 1, memory_order_release);
+    }
+
+    // Wait until everything submitted so far has been sequenced and processed by the books.
+    void wait_idle() const;
+
+    // Sequence number of the last request sequenced, 0 if none.
+    uint64_t last_sequence() const { return next_sequence.load(memory_order_acquire) - 1; }
+};
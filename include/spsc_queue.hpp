@@ -0,0 +1,138 @@
+/*
+* Bounded single-producer/single-consumer queue.
+*
+* A power-of-two ring of slots with a head index written only by the consumer and a tail index
+* written only by the producer, so neither side ever takes a lock. Each side keeps a cached copy
+* of the other's index and only re-reads the shared one when the cache says the ring is full/empty.
+* The consumer's and the producer's fields sit on cache lines of their own, so the two threads
+* never write to the same line.
+*
+* Notes:
+*   - try_push/try_pop never block. push/pop wait for room/a value according to the WaitPolicy:
+*     SpinWait busy-spins (lowest latency, burns a core), FutexWait spins briefly and then sleeps in
+*     atomic::wait (a futex on Linux) until the other side moves.
+*
+* Usage:
+*   SpscQueue<OrderRequest> queue(1024);             // or SpscQueue<OrderRequest, FutexWait>
+*   queue.push(request);                             // Producer thread
+*   OrderRequest next;
+*   queue.pop(next);                                 // Consumer thread
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <thread>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+using namespace std;
+
+// Size of the cache lines the two sides of a queue are kept apart by.
+const size_t CACHE_LINE_SIZE = 64;
+
+// Hint to the CPU that this is a spin loop.
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#else
+    this_thread::yield();
+#endif
+}
+
+// Waits by spinning on the index; nothing to notify.
+struct SpinWait {
+    static void wait(const atomic<size_t>& index, size_t seen) {
+        while (index.load(memory_order_acquire) == seen) cpu_relax();
+    }
+    static void notify(atomic<size_t>&) {}
+};
+
+// Spins for a moment, then sleeps until the other side notifies.
+struct FutexWait {
+    static const int SPINS = 128;
+
+    static void wait(const atomic<size_t>& index, size_t seen) {
+        for (int i = 0; i < SPINS; i++) {
+            if (index.load(memory_order_acquire) != seen) return;
+            cpu_relax();
+        }
+        index.wait(seen, memory_order_acquire);
+    }
+    static void notify(atomic<size_t>& index) { index.notify_one(); }
+};
+
+template <class T, class WaitPolicy = SpinWait>
+class SpscQueue {
+public:
+    /*
+    * @param capacity: Slots in the ring, rounded up to a power of two.
+    */
+    explicit SpscQueue(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) size *= 2;
+        mask  = size - 1;
+        slots = make_unique<T[]>(size);
+    }
+
+    SpscQueue(const SpscQueue&)            = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    // Producer only. Returns false if the ring is full.
+    bool try_push(const T& value) {
+        size_t t = tail.load(memory_order_relaxed);
+        if (t - cached_head > mask) {
+            cached_head = head.load(memory_order_acquire);
+            if (t - cached_head > mask) return false;
+        }
+        slots[t & mask] = value;
+        tail.store(t + 1, memory_order_release);
+        WaitPolicy::notify(tail);
+        return true;
+    }
+
+    // Producer only. Waits while the ring is full.
+    void push(const T& value) {
+        while (!try_push(value)) WaitPolicy::wait(head, cached_head);
+    }
+
+    // Consumer only. Returns false if the ring is empty.
+    bool try_pop(T& value) {
+        size_t h = head.load(memory_order_relaxed);
+        if (h == cached_tail) {
+            cached_tail = tail.load(memory_order_acquire);
+            if (h == cached_tail) return false;
+        }
+        value = slots[h & mask];
+        head.store(h + 1, memory_order_release);
+        WaitPolicy::notify(head);
+        return true;
+    }
+
+    // Consumer only. Waits while the ring is empty.
+    void pop(T& value) {
+        while (!try_pop(value)) WaitPolicy::wait(tail, cached_tail);
+    }
+
+    // Either side; exact only when the other side is idle.
+    bool empty() const {
+        return head.load(memory_order_acquire) == tail.load(memory_order_acquire);
+    }
+
+    size_t capacity() const { return mask + 1; }
+
+private:
+    // Consumer's line.
+    alignas(CACHE_LINE_SIZE) atomic<size_t> head{0}; // Next slot to pop, written by the consumer.
+    size_t cached_tail = 0;                          // Consumer's view of tail.
+
+    // Producer's line.
+    alignas(CACHE_LINE_SIZE) atomic<size_t> tail{0}; // Next slot to push, written by the producer.
+    size_t cached_head = 0;                          // Producer's view of head.
+
+    // Read by both sides, written only by the constructor.
+    alignas(CACHE_LINE_SIZE) unique_ptr<T[]> slots;
+    size_t mask;
+};
@@ -0,0 +1,184 @@
+/*
+* Defines StockOrderBook, which keeps one OrderBook per stock and matches independent stocks in parallel.
+*
+* Symbols are interned into dense SymbolIds by a SymbolRegistry, so nothing on the hot path hashes a
+* string. The books are sharded across a fixed pool of worker threads - symbol s lives on shard
+* s % shard_count - and each shard is fed by its own single-producer/single-consumer queue. A book is
+* only ever touched by the worker of its shard, so the books themselves take no locks.
+*
+* Notes:
+*   - submit() is single producer: call it from one thread only (the thread that reads the feed). To feed
+*     the books from several threads, put a Sequencer (sequencer.hpp) in front.
+*   - Symbols are added before start(); the set of books is fixed while the workers run.
+*   - Events are published on the worker threads. A sink handed out by sink_for_symbol must therefore
+*     be safe to call from the shard's thread; by default every book publishes to a NullSink.
+*
+* Usage:
+*   StockOrderBook stocks(4);                             // 4 shards, tick size 0.001
+*   SymbolId aapl = stocks.add_symbol("AAPL");
+*   stocks.start();
+*   stocks.submit(aapl, OrderRequest::add('B', 50, 10390, 1730764173, 1));
+*   stocks.wait_idle();
+*   TopOfBook top = stocks.book(aapl).top_of_book();
+*/
+
+#pragma once
+
+#include "event_sink.hpp"
+#include "order_book.hpp"
+#include "order_request.hpp"
+#include "price.hpp"
+#include "spsc_queue.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+using namespace std;
+
+using SymbolId = uint32_t;
+
+const SymbolId INVALID_SYMBOL_ID = UINT32_MAX;
+
+class SymbolRegistry {
+    /*
+    * Interns symbol names into dense ids 0, 1, 2, ... in the order they are first seen.
+    */
+
+private:
+    // Transparent hash, so lookups by string_view do not build a string.
+    struct NameHash {
+        using is_transparent = void;
+        size_t operator()(string_view name) const { return hash<string_view>{}(name); }
+    };
+
+    unordered_map<string, SymbolId, NameHash, equal_to<>> ids;
+    vector<string>                                        names;
+
+public:
+    // Id of the symbol, added if it is new.
+    SymbolId intern(string_view name);
+
+    // Id of the symbol, or INVALID_SYMBOL_ID if it was never interned.
+    SymbolId find(string_view name) const;
+
+    const string& name(SymbolId id) const { return names[id]; }
+    size_t size() const { return names.size(); }
+};
+
+class StockOrderBook {
+    /*
+    * Maintains one OrderBook per symbol and provides the following functionalities:
+    * - Register symbols and look them up by name
+    * - Start and stop the shard worker threads
+    * - Route add, cancel and modify requests to the shard that owns the symbol
+    * - Wait for the shards to drain, after which the books may be read from the calling thread
+    */
+
+private:
+    // A request tagged with the book it is for, as it travels through a shard queue.
+    struct ShardRequest {
+        uint32_t     book;     // Index into Shard::books.
+        uint64_t     sequence; // Given by submit()'s caller, 0 if none.
+        OrderRequest request;
+    };
+
+    struct Shard {
+        vector<unique_ptr<OrderBook>> books;     // Symbol shard_index + i * shard_count at index i.
+        SpscQueue<ShardRequest>       queue;
+        thread                        worker;
+        atomic<uint64_t>              submitted{0};     // Written by the producer only.
+        atomic<uint64_t>              processed{0};     // Written by the worker only.
+        atomic<uint64_t>              last_sequence{0}; // Sequence of the last request processed; worker only.
+
+        explicit Shard(size_t queue_capacity) : queue(queue_capacity) {}
+    };
+
+    TickSize                       tick_size;
+    function<EventSink*(SymbolId)> sink_for_symbol;
+    bool                           pin_threads;
+    NullSink                       null_sink;
+    SymbolRegistry                 symbols;
+    vector<unique_ptr<Shard>>      shards;
+    atomic<bool>                   running{false};
+
+    void run_shard(size_t shard_index);
+
+public:
+    /*
+    * @param shard_count:     Number of worker threads. Each one owns the books of every shard_count-th symbol.
+    * @param tick_size:       Tick size of every book.
+    * @param sink_for_symbol: Returns the sink for the book of a symbol, or nullptr for a NullSink.
+    * @param pin_threads:     Pin shard i to CPU i % hardware_concurrency (Linux only).
+    * @param queue_capacity:  Requests each shard queue holds before submit() has to wait.
+    */
+    explicit StockOrderBook(size_t shard_count,
+                            TickSize tick_size = DEFAULT_TICK_SIZE,
+                            function<EventSink*(SymbolId)> sink_for_symbol = {},
+                            bool pin_threads = true,
+                            size_t queue_capacity = 65536);
+
+    ~StockOrderBook();
+
+    StockOrderBook(const StockOrderBook&)            = delete;
+    StockOrderBook& operator=(const StockOrderBook&) = delete;
+
+    /*
+    * @brief
+    * Register a symbol and create its book. Only valid before start().
+    *
+    * @return: id of the symbol; the existing id if it was already registered.
+    */
+    SymbolId add_symbol(string_view name);
+
+    // Id of a registered symbol, or INVALID_SYMBOL_ID.
+    SymbolId find_symbol(string_view name) const { return symbols.find(name); }
+    const string& symbol_name(SymbolId id) const { return symbols.name(id); }
+    size_t symbol_count() const { return symbols.size(); }
+    size_t shard_count() const { return shards.size(); }
+
+    // Launch one worker thread per shard.
+    void start();
+
+    // Process what is already queued, then join the workers. Also done by the destructor.
+    void stop();
+
+    /*
+    * @brief
+    * Queue a request for the book of a symbol. Waits while the shard's queue is full.
+    * Single producer: only one thread may call submit().
+    *
+    * @param symbol:  Registered symbol id.
+    * @param request: Add, cancel or modify request. Ids of a book are its own, so two symbols may reuse an id.
+    * @param sequence: Position of the request in a global order, e.g. the one a Sequencer stamps. Increasing
+    *                  from one call to the next; 0 if the caller keeps none.
+    *
+    * @return: false if the symbol is unknown.
+    */
+    bool submit(SymbolId symbol, const OrderRequest& request, uint64_t sequence = 0);
+
+    // Wait until every shard has processed everything submitted so far. May be called from any thread.
+    void wait_idle() const;
+
+    /*
+    * @brief
+    * Sequence number of the last request the shard of a symbol processed, 0 if none. Everything submitted
+    * for the symbol with a sequence up to this one is reflected in its book.
+    */
+    uint64_t last_sequence(SymbolId symbol) const {
+        return shards[symbol % shards.size()]->last_sequence.load(memory_order_acquire);
+    }
+
+    /*
+    * @brief
+    * Book of a symbol. Only safe to use while the workers are stopped or after wait_idle(), with no
+    * submit() in between.
+    */
+    OrderBook&       book(SymbolId symbol);
+    const OrderBook& book(SymbolId symbol) const;
+};
@@ -0,0 +1,67 @@
+/*
+* Fenwick (binary indexed) tree of the total volume of each level of a bounded price ladder.
+*
+* Keeps prefix sums of the level volumes so "how much volume rests at levels 0..i" is answered in
+* O(log levels) word reads instead of a walk over the levels. This is what a fill-or-kill order asks
+* before it is allowed to trade.
+*
+* Notes:
+*   - Matching changes level volumes all the time and fill-or-kill orders are comparatively rare, so
+*     set() only records the new volume and marks the level; the tree catches up on the marked levels,
+*     O(log levels) each, at the next prefix(). Levels changed many times in between are applied once.
+*
+* Usage:
+*   VolumeTree volumes(1000);
+*   volumes.set(42, 500);
+*   volumes.prefix(100);     // 500
+*/
+
+#pragma once
+
+#include "price.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+using namespace std;
+
+class VolumeTree {
+public:
+    explicit VolumeTree(size_t size) : tree(size + 1, 0), values(size, 0), applied(size, 0), marked(size, 0) {}
+
+    // Set the total volume of level i.
+    void set(size_t i, Quantity volume) {
+        values[i] = volume;
+        if (!marked[i]) {
+            marked[i] = 1;
+            pending.push_back(i);
+        }
+    }
+
+    // Total volume of levels 0..i.
+    Quantity prefix(size_t i) {
+        apply_pending();
+        Quantity sum = 0;
+        for (size_t j = i + 1; j > 0; j -= j & (~j + 1)) sum += tree[j];
+        return sum;
+    }
+
+    // Total volume of all levels.
+    Quantity total() { return values.empty() ? 0 : prefix(values.size() - 1); }
+
+private:
+    vector<Quantity> tree;    // 1-based: tree[j] sums the levels (j - lowbit(j), j].
+    vector<Quantity> values;  // Volume of each level.
+    vector<Quantity> applied; // Volume of each level as the tree has it.
+    vector<uint8_t>  marked;  // Level is in pending.
+    vector<size_t>   pending; // Levels whose volume changed since the tree was last brought up to date.
+
+    void apply_pending() {
+        for (size_t i : pending) {
+            Quantity delta = values[i] - applied[i];
+            applied[i] = values[i];
+            marked[i]  = 0;
+            for (size_t j = i + 1; delta != 0 && j < tree.size(); j += j & (~j + 1)) tree[j] += delta;
+        }
+        pending.clear();
+    }
+};
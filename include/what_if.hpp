@@ -0,0 +1,116 @@
+/*
+* What-if replay: one recorded journal run through many variants of the book at once.
+*
+* Every variant starts from the same WhatIfStart - the resting orders of a book at some journal sequence,
+* taken from a live book or a snapshot file - and replays the journal records after it. A variant may
+* change the tick size, the match policy (self-trade prevention, pro-rata allocation) and inject orders
+* of its own between journal records. The start is shared read-only by all variants: each one copies
+* it into a private book only when it begins, with restore(), so the base state is built once no matter
+* how many variants run, and no variant can see another's changes.
+*
+* The variants run on a pool of threads, each book single-threaded on one of them. Every variant publishes
+* to its own ChecksumSink, so its result - the checksum of all the events it produced, plus trade and
+* reject counts - depends only on the start, the journal and the variant: never on the number of threads
+* or the order they run in. Running one variant with no changes reproduces the recorded book.
+*
+* Notes:
+*   - A variant's tick size keeps the start's decimals and changes only the tick units. If a resting
+*     order of the start is off the variant's tick, the variant cannot start (started is false); journal
+*     adds off its tick are rejected as in any book.
+*   - Journal adds carry the ids the recorded book gave them. Give injected orders ids of their own, out
+*     of the journal's range - an injected order that took a journal id would make that add a duplicate.
+*
+* Usage:
+*   WhatIfStart start;
+*   load_what_if_start("book.snapshot", start);
+*   MappedJournal journal;
+*   journal.open("book.journal");
+*   vector<WhatIfVariant> variants(2);
+*   variants[0].name       = "baseline";
+*   variants[1].name       = "decrement";
+*   variants[1].self_trade = SelfTradePrevention::DECREMENT;
+*   vector<WhatIfResult> results = run_what_if(start, journal.records(), variants);
+*/
+
+#pragma once
+
+#include "depth_cache.hpp"
+#include "journal.hpp"
+#include "match_policy.hpp"
+#include "order_pool.hpp"
+#include "order_record.hpp"
+#include "order_request.hpp"
+#include "price.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+using namespace std;
+
+// State every variant starts from.
+struct WhatIfStart {
+    TickSize            tick_size        = DEFAULT_TICK_SIZE;
+    vector<OrderRecord> orders;                      // Resting orders, in the order export_orders writes them.
+    OrderId             next_order_id    = 1;
+    uint64_t            journal_sequence = 0;        // Last journal record reflected in orders.
+};
+
+// An order a variant adds to the recorded flow.
+struct InjectedRequest {
+    uint64_t     after_sequence; // Applied after the journal record with this sequence, before the next one.
+    OrderRequest request;
+};
+
+struct WhatIfVariant {
+    string                  name;
+    Price                   tick_units = 0;          // Tick size in units of 10^-decimals; 0 keeps the start's.
+    SelfTradePrevention     self_trade = SelfTradePrevention::NONE;
+    bool                    pro_rata   = false;
+    vector<InjectedRequest> injected;                // By after_sequence, ascending.
+};
+
+struct WhatIfResult {
+    bool      started       = false; // false if the start's orders do not fit the variant's book.
+    size_t    requests      = 0;     // Journal records and injected requests applied.
+    uint64_t  checksum      = 0;     // ChecksumSink::checksum of every event the variant published.
+    uint64_t  trades        = 0;
+    Quantity  traded_volume = 0;
+    uint64_t  rejects       = 0;
+    TopOfBook top{};                 // Best levels at the end of the replay.
+};
+
+/*
+* @brief Take the resting orders of a book as the start of a what-if run.
+* @param journal_sequence: Last journal record already applied to the book.
+*/
+template <class Book>
+WhatIfStart what_if_start(const Book& order_book, uint64_t journal_sequence) {
+    WhatIfStart start;
+    start.tick_size        = order_book.tick();
+    start.next_order_id    = order_book.next_id();
+    start.journal_sequence = journal_sequence;
+    order_book.export_orders(start.orders);
+    return start;
+}
+
+/*
+* @brief Load the start of a what-if run from a snapshot file (see book_snapshot.hpp).
+* @return: false if the file is missing or not a valid snapshot.
+*/
+bool load_what_if_start(const string& path, WhatIfStart& start);
+
+/*
+* @brief
+* Replay a journal from a start through every variant, on up to threads threads.
+*
+* @param start:    State every variant starts from.
+* @param journal:  The journal; records up to start.journal_sequence are skipped.
+* @param variants: The variants to run.
+* @param threads:  Threads to run variants on, the calling one included.
+*
+* @return: one result per variant, in the order of variants.
+*/
+vector<WhatIfResult> run_what_if(const WhatIfStart& start, span<const JournalRecord> journal,
+                                 span<const WhatIfVariant> variants, size_t threads = thread::hardware_concurrency());
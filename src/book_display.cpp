@@ -0,0 +1,46 @@
+/*
+* Implementation of BookRenderer
+*/
+
+#include "book_display.hpp"
+#include <charconv>
+using namespace std;
+
+
+void BookRenderer::begin() {
+    frame.clear();
+    frame += '\n';
+    frame += ORDER_BOOK_HEADER;
+}
+
+void BookRenderer::add_row(const DepthLevel* bid, const DepthLevel* ask, const TickSize& tick_size) {
+    frame += '\n';
+    add_cell(bid, tick_size, false);
+    frame += '|';
+    add_cell(ask, tick_size, true);
+}
+
+void BookRenderer::add_cell(const DepthLevel* level, const TickSize& tick_size, bool align_right) {
+    if (level == nullptr) {
+        frame.append(COLUMN_WIDTH, ' '); // Empty cell when no orders left.
+        return;
+    }
+
+    // "<quantity>@<price>", padded to the column width so all rows are aligned.
+    char cell[PRICE_CHARS + 24];
+    char* end = to_chars(cell, cell + 24, level->quantity).ptr;
+    *end++    = '@';
+    end       = format_price_to(end, level->price, tick_size);
+
+    size_t length = static_cast<size_t>(end - cell);
+    size_t pad    = length < COLUMN_WIDTH ? COLUMN_WIDTH - length : 0;
+    if (align_right) frame.append(pad, ' ');
+    frame.append(cell, length);
+    if (!align_right) frame.append(pad, ' ');
+}
+
+void BookRenderer::write(ostream& out) {
+    frame += '\n';
+    out.write(frame.data(), static_cast<streamsize>(frame.size()));
+    out.flush();
+}
@@ -0,0 +1,55 @@
+/*
+* Implementation of snapshot files
+*/
+
+#include "book_snapshot.hpp"
+#include <cerrno>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+using namespace std;
+
+
+// Write the whole buffer, retrying short writes.
+static bool write_all(int fd, const void* data, size_t size) {
+    const char* bytes = static_cast<const char*>(data);
+    while (size > 0) {
+        ssize_t n = ::write(fd, bytes, size);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        bytes += n;
+        size  -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool write_snapshot(const string& path, const SnapshotHeader& header, span<const OrderRecord> orders) {
+    string temporary = path + ".tmp";
+    int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) return false;
+
+    bool success = write_all(fd, &header, sizeof(header)) &&
+                   write_all(fd, orders.data(), orders.size() * sizeof(OrderRecord)) &&
+                   fsync(fd) == 0;
+    success = ::close(fd) == 0 && success;
+    success = success && rename(temporary.c_str(), path.c_str()) == 0;
+    if (!success) unlink(temporary.c_str());
+    return success;
+}
+
+const SnapshotHeader* MappedSnapshot::header() const {
+    string_view file = bytes();
+    if (file.size() < sizeof(SnapshotHeader)) return nullptr;
+
+    const SnapshotHeader* header = reinterpret_cast<const SnapshotHeader*>(file.data());
+    bool complete = header->magic == SNAPSHOT_MAGIC && header->version == SNAPSHOT_VERSION &&
+                    (file.size() - sizeof(SnapshotHeader)) / sizeof(OrderRecord) == header->order_count &&
+                    (file.size() - sizeof(SnapshotHeader)) % sizeof(OrderRecord) == 0;
+    return complete ? header : nullptr;
+}
+
+span<const OrderRecord> MappedSnapshot::orders() const {
+    const SnapshotHeader* snapshot = header();
+    if (snapshot == nullptr) return {};
+    return {reinterpret_cast<const OrderRecord*>(bytes().data() + sizeof(SnapshotHeader)), snapshot->order_count};
+}
@@ -0,0 +1,84 @@
+/*
+* Implementation of PrintingSink and ChecksumSink
+*/
+
+#include "event_sink.hpp"
+#include <iostream>
+using namespace std;
+
+
+void PrintingSink::on_trade(const TradeEvent& trade) {
+    out << "\n" << trade.quantity << "@" << format_price(trade.price, tick_size);
+}
+
+void PrintingSink::on_reject(const RejectEvent& reject) {
+    out << "ERROR: " << input_validation_message(reject.reason, tick_size) << endl;
+}
+
+void PrintingSink::flush() {
+    out << endl;
+}
+
+void ChecksumSink::mix(uint64_t value) {
+    for (int i = 0; i < 8; i++) {
+        hash ^= (value >> (8 * i)) & 0xff;
+        hash *= 0x100000001b3; // FNV-1a prime.
+    }
+}
+
+// Each event starts with a tag of its own, so different events with the same fields differ.
+void ChecksumSink::on_trade(const TradeEvent& trade) {
+    mix('T');
+    mix(trade.maker_id);
+    mix(trade.taker_id);
+    mix(static_cast<uint64_t>(trade.taker_side));
+    mix(static_cast<uint64_t>(trade.price));
+    mix(static_cast<uint64_t>(trade.quantity));
+    trade_count++;
+    volume += trade.quantity;
+}
+
+void ChecksumSink::on_add(const AddEvent& add) {
+    mix('A');
+    mix(add.id);
+    mix(static_cast<uint64_t>(add.side));
+    mix(static_cast<uint64_t>(add.price));
+    mix(static_cast<uint64_t>(add.quantity));
+    mix(add.sequence);
+}
+
+void ChecksumSink::on_cancel(const CancelEvent& cancel) {
+    mix('C');
+    mix(cancel.id);
+    mix(static_cast<uint64_t>(cancel.side));
+    mix(static_cast<uint64_t>(cancel.price));
+    mix(static_cast<uint64_t>(cancel.quantity));
+    mix(static_cast<uint64_t>(cancel.reason));
+}
+
+void ChecksumSink::on_modify(const ModifyEvent& modify) {
+    mix('M');
+    mix(modify.id);
+    mix(static_cast<uint64_t>(modify.side));
+    mix(static_cast<uint64_t>(modify.price));
+    mix(static_cast<uint64_t>(modify.quantity));
+    mix(modify.sequence);
+    mix(static_cast<uint64_t>(modify.reason));
+}
+
+void ChecksumSink::on_reject(const RejectEvent& reject) {
+    mix('R');
+    mix(static_cast<uint64_t>(reject.reason));
+    reject_count++;
+}
+
+void ChecksumSink::on_book_update(const BookUpdateEvent& update) {
+    mix('U');
+    mix(static_cast<uint64_t>(update.side));
+    mix(static_cast<uint64_t>(update.price));
+    mix(static_cast<uint64_t>(update.total_volume));
+}
+
+void ChecksumSink::flush() {
+    mix('F');
+}
@@ -0,0 +1,90 @@
+/*
+* Implementation of Journal
+*/
+
+#include "journal.hpp"
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+using namespace std;
+
+
+Journal::Journal(size_t group_commit) : group_commit(max<size_t>(group_commit, 1)) {
+    buffer.reserve(this->group_commit);
+}
+
+bool Journal::open(const string& path) {
+    close();
+    fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd < 0) return false;
+
+    // Drop a record torn by a crash mid-write, and continue the sequence after the last complete one.
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        close();
+        return false;
+    }
+    off_t complete = info.st_size - info.st_size % static_cast<off_t>(sizeof(JournalRecord));
+    if (complete != info.st_size && ftruncate(fd, complete) != 0) {
+        close();
+        return false;
+    }
+
+    next_sequence = 1;
+    if (complete > 0) {
+        int reader = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        JournalRecord last;
+        bool read = reader >= 0 && pread(reader, &last, sizeof(last), complete - static_cast<off_t>(sizeof(last))) ==
+                                   static_cast<ssize_t>(sizeof(last));
+        if (reader >= 0) ::close(reader);
+        if (!read) {
+            close();
+            return false;
+        }
+        next_sequence = last.sequence + 1;
+    }
+    return true;
+}
+
+uint64_t Journal::append(const OrderRequest& request) {
+    uint64_t sequence = next_sequence++;
+    buffer.push_back(JournalRecord{sequence, request.id, request.quantity, request.price, request.timestamp,
+                                   request.type, request.side, request.order_type, {}, request.account});
+    if (buffer.size() >= group_commit) commit();
+    return sequence;
+}
+
+bool Journal::commit() {
+    if (fd < 0) return false;
+    if (buffer.empty()) return true;
+
+    // One write for the whole group, retried until every byte is out.
+    off_t       start   = lseek(fd, 0, SEEK_END);
+    const char* data    = reinterpret_cast<const char*>(buffer.data());
+    size_t      size    = buffer.size() * sizeof(JournalRecord);
+    size_t      written = 0;
+    while (written < size) {
+        ssize_t n = ::write(fd, data + written, size - written);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            // Cut the file back to where the group started, so it never ends in a torn record, and keep the
+            // whole group buffered. If even that fails, stop appending - open() drops a torn record.
+            if (start < 0 || ftruncate(fd, start) != 0) {
+                ::close(fd);
+                fd = -1;
+            }
+            return false;
+        }
+        written += static_cast<size_t>(n);
+    }
+    buffer.clear();
+    return fdatasync(fd) == 0;
+}
+
+void Journal::close() {
+    if (fd < 0) return;
+    commit();
+    ::close(fd);
+    fd = -1;
+}
@@ -0,0 +1,38 @@
+/*
+* Implementation of MappedFile
+*/
+
+#include "mapped_file.hpp"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+using namespace std;
+
+
+bool MappedFile::open(const string& path) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat info;
+    bool success = fstat(fd, &info) == 0;
+    if (success && info.st_size > 0) {
+        void* mapping = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        success = mapping != MAP_FAILED;
+        if (success) {
+            data   = mapping;
+            length = static_cast<size_t>(info.st_size);
+            // Replays read the file once, front to back.
+            madvise(data, length, MADV_SEQUENTIAL);
+        }
+    }
+    ::close(fd);
+    return success;
+}
+
+void MappedFile::close() {
+    if (data != nullptr) munmap(data, length);
+    data   = nullptr;
+    length = 0;
+}
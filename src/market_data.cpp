@@ -0,0 +1,107 @@
+/*
+* Implementation of the L2 market-data feed
+*/
+
+#include "market_data.hpp"
+#include <algorithm>
+using namespace std;
+
+
+bool L2Book::apply(const L2Header& header, span<const L2Level> levels) {
+    if (header.type == L2MessageType::SNAPSHOT) {
+        bids.clear();
+        asks.clear();
+        for (const L2Level& level : levels) set_level(level);
+        is_synced     = true;
+        last_sequence = header.sequence;
+        return true;
+    }
+
+    // A delta that was seen already (e.g. one a snapshot caught up with) changes nothing.
+    if (is_synced && header.sequence <= last_sequence) return true;
+    if (!is_synced || header.sequence != last_sequence + 1) {
+        bids.clear();
+        asks.clear();
+        is_synced = false;
+        return false;
+    }
+    for (const L2Level& level : levels) set_level(level);
+    last_sequence = header.sequence;
+    return true;
+}
+
+void L2Book::set_level(const L2Level& level) {
+    auto update = [&](auto& side) {
+        if (level.quantity == 0) side.erase(level.price);
+        else                     side[level.price] = level.quantity;
+    };
+    if (level.side == 'B') update(bids);
+    else                   update(asks);
+}
+
+Quantity L2Book::volume(char side, Price price) const {
+    auto find = [&](const auto& levels) {
+        auto level = levels.find(price);
+        return level == levels.end() ? Quantity(0) : level->second;
+    };
+    return side == 'B' ? find(bids) : find(asks);
+}
+
+DepthSnapshot L2Book::depth(size_t levels) const {
+    DepthSnapshot snapshot{};
+    levels = min(levels, MAX_DEPTH);
+    for (auto level = bids.begin(); level != bids.end() && snapshot.bid_levels < levels; ++level)
+        snapshot.bids[snapshot.bid_levels++] = DepthLevel{level->first, level->second};
+    for (auto level = asks.begin(); level != asks.end() && snapshot.ask_levels < levels; ++level)
+        snapshot.asks[snapshot.ask_levels++] = DepthLevel{level->first, level->second};
+    return snapshot;
+}
+
+L2FeedSink::L2FeedSink(ostream& out, uint64_t snapshot_interval) : out(out), snapshot_interval(snapshot_interval) {
+    // Start the stream in sync: an empty book at sequence 0.
+    published.apply(L2Header{0, 0, L2MessageType::SNAPSHOT, {}}, {});
+    write_snapshot();
+}
+
+void L2FeedSink::on_book_update(const BookUpdateEvent& update) {
+    // One incoming order touches few levels, so a linear search finds the one to coalesce with.
+    for (L2Level& level : pending) {
+        if (level.price == update.price && level.side == update.side) {
+            level.quantity = update.total_volume;
+            return;
+        }
+    }
+    pending.push_back(L2Level{update.price, update.total_volume, update.side, {}});
+}
+
+void L2FeedSink::flush() {
+    // Leave out the levels that came back to the volume last published.
+    erase_if(pending, [&](const L2Level& level) { return published.volume(level.side, level.price) == level.quantity; });
+    if (pending.empty()) return;
+
+    L2Header header{published.sequence() + 1, static_cast<uint32_t>(pending.size()), L2MessageType::DELTA, {}};
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(pending.data()), static_cast<streamsize>(pending.size() * sizeof(L2Level)));
+    published.apply(header, pending);
+    pending.clear();
+
+    if (snapshot_interval > 0 && header.sequence % snapshot_interval == 0) write_snapshot();
+}
+
+void L2FeedSink::write_snapshot() {
+    vector<L2Level> levels;
+    levels.reserve(published.bids.size() + published.asks.size());
+    for (const auto& [price, quantity] : published.bids) levels.push_back(L2Level{price, quantity, 'B', {}});
+    for (const auto& [price, quantity] : published.asks) levels.push_back(L2Level{price, quantity, 'S', {}});
+
+    L2Header header{published.sequence(), static_cast<uint32_t>(levels.size()), L2MessageType::SNAPSHOT, {}};
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(levels.data()), static_cast<streamsize>(levels.size() * sizeof(L2Level)));
+}
+
+bool read_l2_message(istream& in, L2Header& header, vector<L2Level>& levels) {
+    if (!in.read(reinterpret_cast<char*>(&header), sizeof(header))) return false;
+    levels.resize(header.level_count);
+    return static_cast<bool>(in.read(reinterpret_cast<char*>(levels.data()),
+                                     static_cast<streamsize>(levels.size() * sizeof(L2Level))));
+}
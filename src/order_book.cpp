@@ -2,174 +2,497 @@
 * Implementation of OrderBook class
 *
 * Notes:
-* - Using two ordered maps - one that maintains a queue of unmatched orders,
-    the other which maintains the total volume of unmatched orders.
-* - Matching happens automatically when the max bid exceeds the min ask.
-*
-* Improvements:
-* - A single multi-map that stores both the queue and the total volume.
+* - Using one ordered map per side, from price to a level holding both the queue of unmatched
+    orders and their total volume - a single tree lookup reaches both.
+* - Orders live in an OrderPool and are linked into the FIFO of their level; the map nodes of the levels
+    come from a NodeArena.
+* - An incoming order is matched against the opposite side as it is added ("aggressive order matching"),
+    and only the unfilled remainder rests. The book is never crossed, so there is no separate sweep.
+* - Each level is filled by LevelFill<Policy> (match_policy.hpp). Under price-time priority a level whose
+    total volume the incoming order covers is taken whole: one walk emits its trades and its queue is
+    spliced back onto the pool's free list (PriceLevel::clear).
+* - The book is a template over its match policy and its stored price and quantity types; the policies the
+    library ships, and OrderBook32, are instantiated at the end of this file.
+* - compact() moves orders between pool nodes by relinking their neighbours, their level's ends and their
+    index entry - nothing else holds a handle between calls.
 */
 
 #include "order_book.hpp"
 #include <iostream>
 #include <algorithm>
 #include <cassert>
+#include <limits>
 #include <map>
 #include <queue>
-#include <regex>
 #include <set>
 #include <string>
 using namespace std;
 
 
-enum class ValidationResult {
-    /* The four horsemen of invalid input */
-    VALID,
-    INVALID_SIDE,
-    INVALID_QUANTITY,
-    INVALID_PRICE
-};
-
-ValidationResult validate_inputs(char side, string quantity, string price) {
-    /*
-    Returns the result of input validation.
-    If there are several invalidities in the input, the first of them is reported.
-    */
-    if (side != 'B' && side != 'S')
-        return ValidationResult::INVALID_SIDE;
-    if (!regex_match(quantity, std::regex("^[1-9][0-9]*$")))
-        return ValidationResult::INVALID_QUANTITY;
-    if (!regex_match(price, std::regex("^[0-9]*\\.?[0-9]+$")) || stof(price) < 1.0/SCALE_FACTOR)
-        return ValidationResult::INVALID_PRICE;
-    return ValidationResult::VALID;
+template <class Policy, class PriceT, class QtyT>
+BasicOrderBook<Policy, PriceT, QtyT>::BasicOrderBook(TickSize tick_size, EventSink* sink)
+                  : tick_size(tick_size), printing_sink(tick_size), sink(sink ? sink : &printing_sink),
+                    buy_orders(&level_arena), sell_orders(&level_arena) {}
+
+template <class Policy, class PriceT, class QtyT>
+OrderId BasicOrderBook<Policy, PriceT, QtyT>::add_order(char side, string_view quantity_str, string_view price_str,
+                                                        long timestamp) {
+
+    // Validate and convert the text fields in one pass - the price comes out already scaled.
+    ParsedOrder order;
+    ValidationResult validation_result = parse_order(side, quantity_str, price_str, tick_size, order);
+    if (validation_result != ValidationResult::VALID) {
+        sink->on_reject(RejectEvent{validation_result});
+        return INVALID_ORDER_ID;
+    }
+    return add_order(order.side, order.quantity, order.price, timestamp);
 }
 
-string input_validation_message(ValidationResult result) {
-    /*
-    Returns a human-readable message corresponding to the input validation result.
-    */
-    switch (result) {
-        case ValidationResult::VALID:
-            return "Good";
-        case ValidationResult::INVALID_SIDE:
-            return "Side should be either \'B\' or \'S\'";
-        case ValidationResult::INVALID_QUANTITY:
-            return "Order quantity should be a positive integer";
-        case ValidationResult::INVALID_PRICE:
-            return format("Price should be a positive value >= tick size ({:.3f})", 1.0/SCALE_FACTOR);
+template <class Policy, class PriceT, class QtyT>
+OrderId BasicOrderBook<Policy, PriceT, QtyT>::add_order(char side, Quantity quantity, Price price, long timestamp,
+                                                        OrderId id, OrderType order_type, AccountId account) {
+    id = accept_order(side, quantity, price, timestamp, id, order_type, account,
+                      validate_order(side, quantity, price, tick_size, order_type), nullptr);
+    if (id != INVALID_ORDER_ID) sink->flush();
+    return id;
+}
+
+template <class Policy, class PriceT, class QtyT>
+size_t BasicOrderBook<Policy, PriceT, QtyT>::add_orders(span<const OrderRequest> requests, span<OrderId> ids) {
+    ValidationResult validation[VALIDATION_BATCH];
+    RestingLevel     last_level;
+    size_t           succeeded = 0;
+
+    for (size_t start = 0; start < requests.size(); start += VALIDATION_BATCH) {
+        span<const OrderRequest> batch = requests.subspan(start, min(VALIDATION_BATCH, requests.size() - start));
+        validate_orders(batch, tick_size, validation);
+
+        for (size_t i = 0; i < batch.size(); i++) {
+            const OrderRequest& request = batch[i];
+            OrderId result = INVALID_ORDER_ID;
+            if (request.type == RequestType::ADD) {
+                result = accept_order(request.side, request.quantity, request.price, request.timestamp,
+                                      request.id, request.order_type, request.account, validation[i], &last_level);
+            } else {
+                // A cancel may empty the level last_level points to.
+                last_level = RestingLevel{};
+                bool done  = request.type == RequestType::CANCEL ? remove_order(request.id)
+                                                                 : amend_order(request.id, request.quantity) == ValidationResult::VALID;
+                result     = done ? request.id : INVALID_ORDER_ID;
+            }
+            if (!ids.empty()) ids[start + i] = result;
+            succeeded += result != INVALID_ORDER_ID;
+        }
     }
-    return "Unknown validation result";
+    if (succeeded > 0) sink->flush();
+    return succeeded;
 }
 
+template <class Policy, class PriceT, class QtyT>
+size_t BasicOrderBook<Policy, PriceT, QtyT>::add_orders(const OrderColumns& orders, long first_timestamp,
+                                                       span<OrderId> ids) {
+    RestingLevel last_level;
+    size_t       accepted = 0;
+    for (size_t i = 0; i < orders.size(); i++) {
+        OrderId id = accept_order(orders.sides[i], orders.quantities[i], orders.prices[i],
+                                  first_timestamp + static_cast<long>(i), INVALID_ORDER_ID, OrderType::LIMIT, DEFAULT_ACCOUNT,
+                                  orders.results[i], &last_level);
+        if (!ids.empty()) ids[i] = id;
+        accepted += id != INVALID_ORDER_ID;
+    }
+    if (accepted > 0) sink->flush();
+    return accepted;
+}
+
+template <class Policy, class PriceT, class QtyT>
+OrderId BasicOrderBook<Policy, PriceT, QtyT>::accept_order(char side, Quantity quantity, Price price, long timestamp,
+                                                           OrderId id, OrderType order_type, AccountId account,
+                                                           ValidationResult validation_result, RestingLevel* last_level) {
+    ScopedTimer timer(instrumentation.add_latency);
+
+    if (validation_result == ValidationResult::VALID)
+        validation_result = check_range(quantity, price, order_type);
+    if (validation_result == ValidationResult::VALID && id != INVALID_ORDER_ID && order_index.find(id) != NULL_ORDER)
+        validation_result = ValidationResult::DUPLICATE_ORDER_ID;
+    if (validation_result == ValidationResult::VALID && risk != nullptr)
+        validation_result = risk->check(account, quantity, price, order_type);
+    if (validation_result == ValidationResult::VALID && order_type == OrderType::POST_ONLY && crosses(side, price))
+        validation_result = ValidationResult::WOULD_CROSS;
+    if (validation_result == ValidationResult::VALID && order_type == OrderType::FOK && !can_fill(side, quantity, price))
+        validation_result = ValidationResult::INSUFFICIENT_LIQUIDITY;
 
-bool OrderBook::add_order(char side, string quantity_str, string price_str, long timestamp) {
+    // Only limit and post-only orders rest; whatever is left of the others is dropped.
+    bool rests = order_type == OrderType::LIMIT || order_type == OrderType::POST_ONLY;
+
+    // The level an order rests at: one map lookup, or none if it is the level the previous order of a batch rested at.
+    auto resting_level = [&]() -> Level& {
+        bool same_level = last_level != nullptr && last_level->level != nullptr &&
+                          last_level->side == side && last_level->price == price;
+        return same_level ? *last_level->level
+                          : on_side(side, [&](auto& book_side) -> Level& { return book_side.levels[price]; });
+    };
+
+    // With 32-bit quantities the level has to hold the order as well. An order that trades has no level of its own
+    // side at its price, as the book is never crossed, so only one that will rest untouched can overflow one: its
+    // level is looked up here, before it is accepted, and not again below.
+    Level* level_ahead = nullptr;
+    if constexpr (sizeof(QtyT) < sizeof(Quantity)) {
+        if (validation_result == ValidationResult::VALID && rests && !crosses(side, price)) {
+            level_ahead = &resting_level();
+            if (!fits_level(*level_ahead, quantity)) validation_result = ValidationResult::QUANTITY_OUT_OF_RANGE;
+        }
+    }
 
-    // Validate inputs and create a new Order.
-    ValidationResult validation_result = validate_inputs(side, quantity_str, price_str);
     if (validation_result != ValidationResult::VALID) {
-        cout << "ERROR: " << input_validation_message(validation_result) << endl;
-        return false;
+        sink->on_reject(RejectEvent{validation_result});
+        return INVALID_ORDER_ID;
     }
 
-    // Scale price by SCALE_FACTOR (inverse of tick size = 1/0.001 = 1000) and ignore the decimal part.
-    long price    = static_cast<long> (stof(price_str) * SCALE_FACTOR);
-    long quantity = stol(quantity_str);
-    
-    // Add new order to the appropriate map and update total volume at the order price.
-    side == 'B' ? buy_orders[price].emplace_back(side, quantity, price, timestamp) 
-                : sell_orders[price].emplace_back(side, quantity, price, timestamp);  
-    
-    side == 'B' ? total_buy_orders_at_price[price] += quantity 
-                : total_sell_orders_at_price[price] += quantity;  
-                  
+    // Ids the book assigns itself always stay above any id chosen by a caller.
+    if (id == INVALID_ORDER_ID) id = next_order_id++;
+    else                        next_order_id = max(next_order_id, id + 1);
+
+    // A market order trades at whatever prices the opposite side offers.
+    Price limit = order_type != OrderType::MARKET ? price
+                : side == 'B'                     ? numeric_limits<Price>::max() : numeric_limits<Price>::min();
+    Quantity remaining = match(id, side, account, quantity, limit);
+    instrumentation.order_matched();
+
+    // Matching may have emptied and erased the level last_level points to.
+    if (last_level != nullptr && remaining != quantity) *last_level = RestingLevel{};
+
+    // Rest what is left in the appropriate level and update total volume at the order price.
+    if (remaining > 0 && rests) {
+        OrderHandle new_order = order_pool.allocate(id, side, remaining, price, timestamp, next_sequence++, account);
+        if (risk != nullptr) risk->opened(account, remaining);
+        Level& level = level_ahead != nullptr ? *level_ahead : resting_level();
+        if (level.empty()) instrumentation.level_created(side);
+        level.push_back(order_pool, new_order);
+        order_index.insert(id, new_order);
+        if (last_level != nullptr) *last_level = RestingLevel{side, price, &level};
+
+        sink->on_add(AddEvent{id, side, price, remaining, order_pool.info(new_order).sequence});
+        level_updated(side, price, level.total_volume);
+    }
+    return id;
+}
+
+template <class Policy, class PriceT, class QtyT>
+OrderId BasicOrderBook<Policy, PriceT, QtyT>::submit(const OrderRequest& request) {
+    switch (request.type) {
+        case RequestType::ADD:
+            return add_order(request.side, request.quantity, request.price, request.timestamp, request.id,
+                             request.order_type, request.account);
+        case RequestType::CANCEL:
+            return cancel_order(request.id) ? request.id : INVALID_ORDER_ID;
+        case RequestType::MODIFY:
+            return modify_order(request.id, request.quantity) == ValidationResult::VALID ? request.id : INVALID_ORDER_ID;
+    }
+    return INVALID_ORDER_ID;
+}
+
+template <class Policy, class PriceT, class QtyT>
+bool BasicOrderBook<Policy, PriceT, QtyT>::cancel_order(OrderId id) {
+    bool cancelled = remove_order(id);
+    if (cancelled) sink->flush();
+    return cancelled;
+}
+
+template <class Policy, class PriceT, class QtyT>
+bool BasicOrderBook<Policy, PriceT, QtyT>::remove_order(OrderId id) {
+    ScopedTimer timer(instrumentation.cancel_latency);
+    OrderHandle handle = order_index.find(id);
+    if (handle == NULL_ORDER) return false;
+
+    // The order itself is found through the index; its level only costs a map lookup by its price.
+    const auto& info = order_pool.info(handle);
+    CancelEvent cancel{id, info.side, info.price, order_pool[handle].quantity, AmendReason::REQUEST};
+    if (risk != nullptr) risk->closed(info.account, cancel.quantity);
+    on_side(cancel.side, [&](auto& book_side) {
+        auto level = book_side.levels.find(cancel.price);
+        order_index.erase(id);
+        level->second.remove(order_pool, handle);
+
+        sink->on_cancel(cancel);
+        level_updated(cancel.side, cancel.price, level->second.total_volume);
+        if (level->second.empty()) book_side.levels.erase(level);
+    });
     return true;
 }
 
-void OrderBook::execute_and_print_trades() {
+template <class Policy, class PriceT, class QtyT>
+ValidationResult BasicOrderBook<Policy, PriceT, QtyT>::modify_order(OrderId id, Quantity new_quantity) {
+    ValidationResult result = amend_order(id, new_quantity);
+    if (result == ValidationResult::VALID) sink->flush();
+    return result;
+}
+
+template <class Policy, class PriceT, class QtyT>
+ValidationResult BasicOrderBook<Policy, PriceT, QtyT>::amend_order(OrderId id, Quantity new_quantity) {
+    ScopedTimer timer(instrumentation.modify_latency);
+    OrderHandle handle = order_index.find(id);
+    if (handle == NULL_ORDER) return ValidationResult::UNKNOWN_ORDER_ID;
+    if (new_quantity <= 0)    return ValidationResult::INVALID_QUANTITY;
+
+    auto&  order = order_pool[handle];
+    auto&  info  = order_pool.info(handle);
+    Level& level = on_side(info.side, [&](auto& book_side) -> Level& { return book_side.levels.find(info.price)->second; });
+
+    // The level's total volume has to stay in the range the book stores it in.
+    if (!fits_level(level, new_quantity - order.quantity)) return ValidationResult::QUANTITY_OUT_OF_RANGE;
+
+    // An increase is held to the account's limits like a new order of new_quantity, and rejected like one.
+    if (risk != nullptr) {
+        if (new_quantity > order.quantity) {
+            ValidationResult result = risk->can_amend(info.account, new_quantity, info.price, new_quantity - order.quantity);
+            if (result != ValidationResult::VALID) {
+                sink->on_reject(RejectEvent{result});
+                return result;
+            }
+        }
+        if (new_quantity < order.quantity) risk->closed(info.account, order.quantity - new_quantity);
+        else                               risk->opened(info.account, new_quantity - order.quantity);
+    }
+
+    if (new_quantity <= order.quantity) {
+        // Reducing quantity keeps the order's place in the queue.
+        level.total_volume -= order.quantity - new_quantity;
+        order.quantity      = new_quantity;
+    } else {
+        // Increasing it sends the order to the back of its level, with a new sequence number.
+        level.unlink(order_pool, handle);
+        order.quantity = new_quantity;
+        info.sequence  = next_sequence++;
+        level.push_back(order_pool, handle);
+    }
+
+    sink->on_modify(ModifyEvent{id, info.side, info.price, order.quantity, info.sequence, AmendReason::REQUEST});
+    level_updated(info.side, info.price, level.total_volume);
+    return ValidationResult::VALID;
+}
+
+template <class Policy, class PriceT, class QtyT>
+Quantity BasicOrderBook<Policy, PriceT, QtyT>::match(OrderId id, char side, AccountId account, Quantity quantity,
+                                                     Price price) {
+    return side == 'B' ? match_side(sell_orders, id, account, quantity, price)
+                       : match_side(buy_orders,  id, account, quantity, price);
+}
 
-    // Start by matching the most enticing buy order with the most enticing sell order.
-    // Keep going until the maximum bid is less than the minimum ask. 
-    while(!(buy_orders.empty() || sell_orders.empty())) {
-        Order best_buy_order  = buy_orders.rbegin()->second.front();
-        Order best_sell_order = sell_orders.begin()->second.front();
+template <class Policy, class PriceT, class QtyT>
+template <class Opposite>
+Quantity BasicOrderBook<Policy, PriceT, QtyT>::match_side(Opposite& opposite, OrderId id, AccountId account,
+                                                          Quantity quantity, Price price) {
+    constexpr char side = Opposite::side == 'B' ? 'S' : 'B';
 
-        long buy_order_price  = best_buy_order.price;
-        long sell_order_price = best_sell_order.price;
+    // Walk the opposite side from its best level for as long as the incoming order crosses it.
+    // The best level is the first of the tree, so reaching it never descends the tree.
+    while (quantity > 0 && opposite.crossed_by(price)) {
+        auto best_level = opposite.levels.begin();
+        quantity = LevelFill<Policy>::fill(*this, best_level->second, best_level->first, id, side, account, quantity);
+        if (best_level->second.empty()) opposite.levels.erase(best_level);
+    }
+    return quantity;
+}
 
-        if (buy_order_price < sell_order_price) break;
+template <class Policy, class PriceT, class QtyT>
+bool BasicOrderBook<Policy, PriceT, QtyT>::crosses(char side, Price price) const {
+    return side == 'B' ? sell_orders.crossed_by(price) : buy_orders.crossed_by(price);
+}
 
-        long trade_quantity = min(best_buy_order.quantity, best_sell_order.quantity);
-        long trade_price    = best_buy_order.timestamp > best_sell_order.timestamp ? 
-                              sell_order_price : buy_order_price;
+template <class Policy, class PriceT, class QtyT>
+ValidationResult BasicOrderBook<Policy, PriceT, QtyT>::check_range(Quantity quantity, Price price,
+                                                                   OrderType order_type) const {
+    if constexpr (sizeof(PriceT) < sizeof(Price)) {
+        if (order_type != OrderType::MARKET && !fits_price(price)) return ValidationResult::PRICE_OUT_OF_RANGE;
+    }
+    if constexpr (sizeof(QtyT) < sizeof(Quantity)) {
+        if (!fits_quantity(quantity)) return ValidationResult::QUANTITY_OUT_OF_RANGE;
+    }
+    return ValidationResult::VALID;
+}
 
-        // Print the trade that is to be executed                 
-        cout << "\n" << trade_quantity << "@" << (trade_price * 1.0f / SCALE_FACTOR);
+template <class Policy, class PriceT, class QtyT>
+bool BasicOrderBook<Policy, PriceT, QtyT>::can_fill(char side, Quantity quantity, Price price) const {
+    // Walk the levels the order would trade against, best first, adding up their volume.
+    auto enough = [&](const auto& opposite) {
+        Quantity total = 0;
+        for (auto level = opposite.levels.begin(); level != opposite.levels.end() && opposite.reaches(price, level->first); level++)
+            if ((total += level->second.total_volume) >= quantity) return true;
+        return false;
+    };
+    return side == 'B' ? enough(sell_orders) : enough(buy_orders);
+}
 
-        // Update order quantities as per executed trade
-        best_buy_order.quantity  -= trade_quantity;
-        best_sell_order.quantity -= trade_quantity;
+template <class Policy, class PriceT, class QtyT>
+void BasicOrderBook<Policy, PriceT, QtyT>::print_order_book(size_t max_levels) {
+    renderer.begin();
 
-        buy_orders.rbegin()->second.front().quantity -= trade_quantity;
-        sell_orders.begin()->second.front().quantity -= trade_quantity;
+    // Display the buy orders from the maximum price down, and the sell orders from the minimum price up.
+    auto itB = buy_orders.levels.begin(),  itBend = buy_orders.levels.end();
+    auto itS = sell_orders.levels.begin(), itSend = sell_orders.levels.end();
 
-        total_buy_orders_at_price[buy_order_price]  -= trade_quantity;
-        total_sell_orders_at_price[sell_order_price] -= trade_quantity;
+    for (size_t row = 0; row < max_levels && (itB != itBend || itS != itSend); row++) {
+        DepthLevel bid, ask;
+        const DepthLevel* bid_cell = nullptr;
+        const DepthLevel* ask_cell = nullptr;
 
-        if (best_buy_order.quantity == 0) {
-            buy_orders.rbegin()->second.pop_front();
-            if (total_buy_orders_at_price[buy_order_price] == 0) {
-                // Make sure both data structures are consistent.
-                // Total volume of orders at price is 0 => then the queue of orders at that price should be empty.
-                assert(buy_orders[buy_order_price].empty());
+        if (itB != itBend) {
+            bid      = DepthLevel{itB->first, itB->second.total_volume};
+            bid_cell = &bid;
+            ++itB;
+        }
+        if (itS != itSend) {
+            ask      = DepthLevel{itS->first, itS->second.total_volume};
+            ask_cell = &ask;
+            ++itS;
+        }
+        renderer.add_row(bid_cell, ask_cell, tick_size);
+    }
+    renderer.write(cout);
+}
+
+template <class Policy, class PriceT, class QtyT>
+TopOfBook BasicOrderBook<Policy, PriceT, QtyT>::top_of_book() const {
+    TopOfBook top{};
+    auto best = [](const auto& book_side) {
+        return book_side.levels.empty() ? DepthLevel{}
+                                        : DepthLevel{book_side.levels.begin()->first, book_side.levels.begin()->second.total_volume};
+    };
+    top.bid = best(buy_orders);
+    top.ask = best(sell_orders);
+    return top;
+}
+
+template <class Policy, class PriceT, class QtyT>
+DepthSnapshot BasicOrderBook<Policy, PriceT, QtyT>::depth(size_t levels) {
+
+    // Refill a side whose top N lost a level, from the best MAX_DEPTH levels of its map.
+    auto refill = [](DepthCache::Side& cached, auto it, auto end) {
+        cached.reset();
+        for (; it != end && !cached.full(); it++) cached.push_back(it->first, it->second.total_volume);
+    };
+    if (depth_cache.bids.dirty) refill(depth_cache.bids, buy_orders.levels.begin(), buy_orders.levels.end());
+    if (depth_cache.asks.dirty) refill(depth_cache.asks, sell_orders.levels.begin(), sell_orders.levels.end());
 
-                // Remove from both maps.
-                total_buy_orders_at_price.erase(buy_order_price);
-                buy_orders.erase(buy_order_price);
+    DepthSnapshot snapshot{};
+    levels = min(levels, MAX_DEPTH);
+    snapshot.bid_levels = static_cast<uint32_t>(min<size_t>(levels, depth_cache.bids.count));
+    snapshot.ask_levels = static_cast<uint32_t>(min<size_t>(levels, depth_cache.asks.count));
+    copy_n(depth_cache.bids.levels, snapshot.bid_levels, snapshot.bids);
+    copy_n(depth_cache.asks.levels, snapshot.ask_levels, snapshot.asks);
+    return snapshot;
+}
+
+template <class Policy, class PriceT, class QtyT>
+void BasicOrderBook<Policy, PriceT, QtyT>::export_orders(vector<OrderRecord>& orders) const {
+    orders.reserve(orders.size() + order_index.size());
+    auto export_side = [&](const auto& book_side) {
+        for (const auto& [price, level] : book_side.levels) {
+            for (OrderHandle handle = level.head; handle != NULL_ORDER; handle = order_pool[handle].next) {
+                const auto& info = order_pool.info(handle);
+                orders.push_back(OrderRecord{order_pool[handle].id, order_pool[handle].quantity, info.price, info.timestamp,
+                                             info.side, {}, info.account});
             }
         }
-        if (best_sell_order.quantity == 0) {
-            sell_orders.begin()->second.pop_front();
-            if (total_sell_orders_at_price[sell_order_price] == 0) {
-                // Make sure both data structures are consistent.
-                // Total volume of orders at price is 0 => then the queue of orders at that price should be empty.
-                assert(sell_orders[sell_order_price].empty());
-
-                //Remove from both maps
-                total_sell_orders_at_price.erase(sell_order_price);
-                sell_orders.erase(sell_order_price);
+    };
+    export_side(buy_orders);
+    export_side(sell_orders);
+}
+
+template <class Policy, class PriceT, class QtyT>
+bool BasicOrderBook<Policy, PriceT, QtyT>::restore(span<const OrderRecord> orders, OrderId next_order_id) {
+    if (!buy_orders.levels.empty() || !sell_orders.levels.empty()) return false;
+    for (const OrderRecord& record : orders)
+        if (record.id == INVALID_ORDER_ID ||
+            validate_order(record.side, record.quantity, record.price, tick_size) != ValidationResult::VALID ||
+            !fits_price(record.price) || !fits_quantity(record.quantity) ||
+            (risk != nullptr && record.account >= risk->accounts())) return false;
+
+    // Orders come best price first, so each level is found or created at the end of its map without a tree search.
+    OrderId max_id = INVALID_ORDER_ID;
+    for (size_t i = 0; i < orders.size(); i++) {
+        const OrderRecord& record = orders[i];
+        Level&             level  = on_side(record.side, [&](auto& book_side) -> Level& {
+            return book_side.levels.emplace_hint(book_side.levels.end(), record.price, Level{})->second;
+        });
+        if (order_index.find(record.id) != NULL_ORDER || !fits_level(level, record.quantity)) {
+            // A duplicate id, or a level the book cannot hold: undo the orders loaded so far.
+            for (size_t j = 0; j < i; j++) {
+                order_pool.release(order_index.find(orders[j].id));
+                order_index.erase(orders[j].id);
             }
+            buy_orders.levels.clear();
+            sell_orders.levels.clear();
+            return false;
         }
+
+        OrderHandle handle = order_pool.allocate(record.id, record.side, record.quantity, record.price, record.timestamp,
+                                                 next_sequence++, record.account);
+        if (level.empty()) instrumentation.level_created(record.side);
+        level.push_back(order_pool, handle);
+        order_index.insert(record.id, handle);
+        max_id = max(max_id, record.id);
     }
-    cout << endl;
-}
-
-void OrderBook::print_order_book() {
-
-    // Start by printing the order book header
-    cout << "\n" << ORDER_BOOK_HEADER;
-    
-    // Display the buy orders from the right end i.e maximum price first. For sell orders, minimum price first.
-    auto itB = total_buy_orders_at_price.rbegin(), itBend = total_buy_orders_at_price.rend();
-    auto itS = total_sell_orders_at_price.begin(), itSend = total_sell_orders_at_price.end();
-
-    while (itB != itBend || itS != itSend) {
-        string row = "";
-
-        auto append_cell = [&](auto& it, auto end, bool align) {
-            if (it == end) return string(COLUMN_WIDTH, ' '); // Empty cell when no orders left.
-            string cell = format("{}@{}", it->second, it->first * 1.0f / SCALE_FACTOR);
-
-            // Get the right padding for the cell's contents so all rows are aligned.
-            size_t pad  = COLUMN_WIDTH - cell.size();
-            align ? cell.insert(0, pad, ' ') : cell.append(pad, ' ');
-            it++;
-            return cell;
-        };
-        
-        row += append_cell(itB, itBend, 0);
-        row += '|';
-        row += append_cell(itS, itSend, 1);
-        cout << "\n" << row;
+
+    if (risk != nullptr)
+        for (const OrderRecord& record : orders) risk->opened(record.account, record.quantity);
+    this->next_order_id = max(next_order_id, max_id + 1);
+    depth_cache.bids.dirty = depth_cache.asks.dirty = true;
+    return true;
+}
+
+template <class Policy, class PriceT, class QtyT>
+BookFootprint BasicOrderBook<Policy, PriceT, QtyT>::footprint() const {
+    BookFootprint footprint;
+    footprint.levels              = buy_orders.levels.size() + sell_orders.levels.size();
+    footprint.level_bytes         = level_arena.bytes();
+    footprint.level_bytes_in_use  = level_arena.bytes_in_use();
+    footprint.orders              = order_pool.size();
+    footprint.order_pool_capacity = order_pool.capacity();
+    footprint.order_pool_bytes    = order_pool.capacity() * Pool::NODE_BYTES;
+    footprint.order_bytes_in_use  = order_pool.size() * Pool::NODE_BYTES;
+    footprint.index_slots         = order_index.capacity();
+    footprint.index_bytes         = order_index.bytes();
+    footprint.fixed_bytes         = sizeof(*this) + renderer.capacity();
+    return footprint;
+}
+
+template <class Policy, class PriceT, class QtyT>
+size_t BasicOrderBook<Policy, PriceT, QtyT>::compact(size_t max_chunks) {
+    size_t before = footprint().total_bytes();
+
+    // Keep the chunks the resting orders fill, and at least one.
+    size_t needed = max<size_t>(1, (order_pool.size() + Pool::CHUNK_SIZE - 1) / Pool::CHUNK_SIZE);
+    size_t chunks = order_pool.chunk_count();
+    if (chunks > needed) {
+        order_pool.shrink(chunks - min(chunks - needed, max_chunks), [&](OrderHandle handle) {
+            const auto& order = order_pool[handle];
+            const auto& info  = order_pool.info(handle);
+            if (order.prev == NULL_ORDER || order.next == NULL_ORDER) {
+                Level& level = on_side(info.side, [&](auto& book_side) -> Level& {
+                    return book_side.levels.find(info.price)->second;
+                });
+                if (order.prev == NULL_ORDER) level.head = handle;
+                if (order.next == NULL_ORDER) level.tail = handle;
+            }
+            if (order.prev != NULL_ORDER) order_pool[order.prev].next = handle;
+            if (order.next != NULL_ORDER) order_pool[order.next].prev = handle;
+            order_index.update(order.id, handle);
+        });
     }
-    cout << endl;
+    level_arena.trim();
+    order_index.shrink_to_fit();
+    return before - footprint().total_bytes();
 }
+
+// The match policies the library is built with; other policies need their own instantiation here. Of the narrow
+// books only OrderBook32 is built.
+template class BasicOrderBook<PriceTimePolicy>;
+template class BasicOrderBook<PriceTimePolicy, int32_t, int32_t>;
+template class BasicOrderBook<MatchPolicy<SelfTradePrevention::CANCEL_NEWEST>>;
+template class BasicOrderBook<MatchPolicy<SelfTradePrevention::CANCEL_OLDEST>>;
+template class BasicOrderBook<MatchPolicy<SelfTradePrevention::DECREMENT>>;
+template class BasicOrderBook<MatchPolicy<SelfTradePrevention::NONE, ProRataAllocation>>;
+template class BasicOrderBook<MatchPolicy<SelfTradePrevention::CANCEL_NEWEST, ProRataAllocation>>;
+template class BasicOrderBook<MatchPolicy<SelfTradePrevention::CANCEL_OLDEST, ProRataAllocation>>;
+template class BasicOrderBook<MatchPolicy<SelfTradePrevention::DECREMENT, ProRataAllocation>>;
@@ -0,0 +1,147 @@
+/*
+* Implementation of the text order parser.
+*
+* Notes:
+* - Each field is scanned exactly once, accumulating digits into an int64 with an overflow check per digit.
+* - The price is scaled while it is parsed: integer digits then up to tick_size.decimals fractional
+*   digits, any further fractional digits are validated and dropped. The result is then truncated
+*   down to the tick (truncation, as before).
+*/
+
+#include "order_parser.hpp"
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+using namespace std;
+
+
+static bool is_digit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+const int64_t INT64_MAX_VALUE = numeric_limits<int64_t>::max();
+
+// Append a digit to value, returning false if the result would not fit in 64 bits.
+static bool push_digit(int64_t& value, char digit) {
+    int64_t d = digit - '0';
+    if (value > (INT64_MAX_VALUE - d) / 10) return false;
+    value = value * 10 + d;
+    return true;
+}
+
+static bool parse_quantity(string_view text, Quantity& quantity) {
+    if (text.empty() || text[0] == '0') return false;
+
+    quantity = 0;
+    for (char c : text) {
+        if (!is_digit(c) || !push_digit(quantity, c)) return false;
+    }
+    return true;
+}
+
+static bool parse_price(string_view text, const TickSize& tick_size, Price& price) {
+    size_t i = 0, n = text.size();
+
+    // Integer part, possibly empty (".5" is a valid price).
+    Price integer_part = 0;
+    for (; i < n && is_digit(text[i]); i++) {
+        if (!push_digit(integer_part, text[i])) return false;
+    }
+
+    // Each fractional digit consumed divides the weight of the remaining ones by 10.
+    Price scale    = tick_size.scale();
+    Price fraction = 0;
+    if (i < n && text[i] == '.') {
+        // At least one digit must follow the decimal point.
+        if (++i == n) return false;
+        for (; i < n && is_digit(text[i]); i++) {
+            if (scale == 1) continue; // Finer than the price precision - truncated.
+            fraction = fraction * 10 + (text[i] - '0');
+            scale   /= 10;
+        }
+    } else if (i == 0) {
+        return false; // Neither integer digits nor a fraction.
+    }
+    if (i != n) return false;
+
+    Price one = tick_size.scale();
+    if (integer_part > (INT64_MAX_VALUE - one) / one) return false;
+    price = tick_size.round_down(integer_part * one + fraction * scale);
+    return true;
+}
+
+ValidationResult validate_order(char side, Quantity quantity, Price price, const TickSize& tick_size,
+                                OrderType order_type) {
+    if (side != 'B' && side != 'S')
+        return ValidationResult::INVALID_SIDE;
+    if (quantity <= 0)
+        return ValidationResult::INVALID_QUANTITY;
+    if (order_type != OrderType::MARKET && (price < tick_size.units || price % tick_size.units != 0))
+        return ValidationResult::INVALID_PRICE;
+    return ValidationResult::VALID;
+}
+
+void validate_orders(span<const OrderRequest> requests, const TickSize& tick_size, ValidationResult* results) {
+    // Same checks and order of precedence as validate_order, as selects; units of 1 skip the division.
+    bool whole_units = tick_size.units == 1;
+    for (size_t i = 0; i < requests.size(); i++) {
+        const OrderRequest& request = requests[i];
+        bool bad_side     = request.side != 'B' && request.side != 'S';
+        bool bad_quantity = request.quantity <= 0;
+        bool bad_price    = request.order_type != OrderType::MARKET &&
+                            (request.price < tick_size.units || (!whole_units && request.price % tick_size.units != 0));
+
+        ValidationResult result = bad_side     ? ValidationResult::INVALID_SIDE
+                                : bad_quantity ? ValidationResult::INVALID_QUANTITY
+                                : bad_price    ? ValidationResult::INVALID_PRICE
+                                :                ValidationResult::VALID;
+        results[i] = request.type == RequestType::ADD ? result : ValidationResult::VALID;
+    }
+}
+
+ValidationResult parse_order(char side, string_view quantity, string_view price,
+                             const TickSize& tick_size, ParsedOrder& order) {
+    order.side = side;
+    if (side != 'B' && side != 'S')
+        return ValidationResult::INVALID_SIDE;
+    if (!parse_quantity(quantity, order.quantity))
+        return ValidationResult::INVALID_QUANTITY;
+    if (!parse_price(price, tick_size, order.price))
+        return ValidationResult::INVALID_PRICE;
+    return validate_order(order.side, order.quantity, order.price, tick_size);
+}
+
+string input_validation_message(ValidationResult result, const TickSize& tick_size) {
+    switch (result) {
+        case ValidationResult::VALID:
+            return "Good";
+        case ValidationResult::INVALID_SIDE:
+            return "Side should be either \'B\' or \'S\'";
+        case ValidationResult::INVALID_QUANTITY:
+            return "Order quantity should be a positive integer";
+        case ValidationResult::INVALID_PRICE:
+            return "Price should be a positive value >= tick size (" + format_price(tick_size.units, tick_size) + ")";
+        case ValidationResult::PRICE_OUT_OF_RANGE:
+            return "Price is outside the price range of this order book";
+        case ValidationResult::DUPLICATE_ORDER_ID:
+            return "Order id is already in use by a resting order";
+        case ValidationResult::WOULD_CROSS:
+            return "Post-only order would trade on arrival";
+        case ValidationResult::INSUFFICIENT_LIQUIDITY:
+            return "Fill-or-kill order cannot be filled in full";
+        case ValidationResult::UNKNOWN_ACCOUNT:
+            return "Account is not known to the risk checks";
+        case ValidationResult::ORDER_QUANTITY_LIMIT:
+            return "Order quantity exceeds the account's limit";
+        case ValidationResult::NOTIONAL_LIMIT:
+            return "Order notional exceeds the account's limit";
+        case ValidationResult::EXPOSURE_LIMIT:
+            return "Order would take the account's open quantity over its limit";
+        case ValidationResult::UNKNOWN_ORDER_ID:
+            return "No resting order with this id";
+        case ValidationResult::QUANTITY_OUT_OF_RANGE:
+            return "Quantity is outside the quantity range of this order book";
+    }
+    return "Unknown validation result";
+}
@@ -0,0 +1,246 @@
+/*
+* Implementation of the bulk order tokenizer.
+*
+* Notes:
+* - The buffer is classified 64 bytes at a time into a separator mask (space, tab, comma, '\r', '\n')
+*   and a newline mask. Token boundaries are the bits where separator and non-separator bytes meet,
+*   so the loop only visits boundaries and newlines, never individual bytes.
+* - The last partial block is copied into a block padded with newlines, which also ends a last line
+*   that has no newline of its own.
+* - Fields are kept as offsets into the buffer and converted when their line ends.
+*/
+
+#include "order_tokenizer.hpp"
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+using namespace std;
+
+
+static const size_t BLOCK_SIZE = 64;
+static const size_t NO_TOKEN   = SIZE_MAX;
+
+static const int64_t POWERS_OF_10[] = {1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000};
+
+struct BlockMasks {
+    uint64_t separators; // Bit i set if byte i of the block separates fields, newlines included.
+    uint64_t newlines;
+};
+
+static BlockMasks classify(const char* block) {
+    uint64_t separators = 0, newlines = 0;
+#if defined(__AVX2__)
+    for (size_t half = 0; half < 2; half++) {
+        __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + 32 * half));
+        __m256i nl    = _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\n'));
+        __m256i sep   = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(' ')),
+                                                        _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(','))),
+                                        _mm256_or_si256(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\t')),
+                                                        _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\r'))));
+        newlines   |= uint64_t(uint32_t(_mm256_movemask_epi8(nl))) << (32 * half);
+        separators |= uint64_t(uint32_t(_mm256_movemask_epi8(_mm256_or_si256(sep, nl)))) << (32 * half);
+    }
+#elif defined(__SSE2__)
+    for (size_t quarter = 0; quarter < 4; quarter++) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 16 * quarter));
+        __m128i nl    = _mm_cmpeq_epi8(bytes, _mm_set1_epi8('\n'));
+        __m128i sep   = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(' ')),
+                                                  _mm_cmpeq_epi8(bytes, _mm_set1_epi8(','))),
+                                     _mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('\t')),
+                                                  _mm_cmpeq_epi8(bytes, _mm_set1_epi8('\r'))));
+        newlines   |= uint64_t(uint32_t(_mm_movemask_epi8(nl))) << (16 * quarter);
+        separators |= uint64_t(uint32_t(_mm_movemask_epi8(_mm_or_si128(sep, nl)))) << (16 * quarter);
+    }
+#else
+    for (size_t i = 0; i < BLOCK_SIZE; i++) {
+        char c = block[i];
+        newlines   |= uint64_t(c == '\n') << i;
+        separators |= uint64_t(c == '\n' || c == ' ' || c == ',' || c == '\t' || c == '\r') << i;
+    }
+#endif
+    return BlockMasks{separators, newlines};
+}
+
+/*
+* Value of 0 to 8 decimal digits (SWAR: all eight at once in one 64-bit word). Returns false if any of
+* them is not a digit. Reads 8 bytes from digits when overread is allowed, only len bytes otherwise.
+*/
+static inline bool parse_digits(const char* digits, size_t len, bool overread, int64_t& value) {
+    uint64_t chunk = 0;
+    if (overread) memcpy(&chunk, digits, 8);
+    else          for (size_t i = 0; i < len; i++) chunk |= uint64_t(uint8_t(digits[i])) << (8 * i);
+    if (len < 8) {
+        // Move the digits to the high (least significant) end and fill the front with '0's. No digits
+        // at all read as 0; a select rather than an early return, as field lengths are unpredictable.
+        uint64_t kept = len == 0 ? 0 : chunk << (8 * (8 - len));
+        chunk         = kept | (0x3030303030303030ULL >> (8 * len));
+    }
+    if (((chunk & 0xF0F0F0F0F0F0F0F0ULL) |
+         (((chunk + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4)) != 0x3333333333333333ULL)
+        return false;
+
+    chunk = ((chunk & 0x0F0F0F0F0F0F0F0FULL) * 2561) >> 8;
+    chunk = ((chunk & 0x00FF00FF00FF00FFULL) * 6553601) >> 16;
+    value = static_cast<int64_t>(((chunk & 0x0000FFFF0000FFFFULL) * 42949672960001ULL) >> 32);
+    return true;
+}
+
+namespace {
+
+// Fields of the line being tokenized, as offsets into the buffer.
+struct LineFields {
+    size_t starts[3];
+    size_t ends[3];
+    size_t count = 0;
+};
+
+class RowParser {
+    string_view     text;
+    const TickSize& tick_size;
+    OrderColumns&   orders;
+    Price           one; // 1.0 in price units.
+
+public:
+    RowParser(string_view text, const TickSize& tick_size, OrderColumns& orders)
+        : text(text), tick_size(tick_size), orders(orders), one(tick_size.scale()) {}
+
+    // Whether the 8 bytes at offset can be read without leaving the buffer.
+    bool can_overread(size_t offset) const { return offset + 8 <= text.size(); }
+
+    inline void append(char side, Quantity quantity, Price price, ValidationResult result) {
+        orders.sides.push_back(side);
+        orders.quantities.push_back(quantity);
+        orders.prices.push_back(price);
+        orders.results.push_back(result);
+    }
+
+    // Fall back to the scalar parser for fields the fast path does not cover.
+    void append_parsed(char side, string_view quantity, string_view price) {
+        ParsedOrder order{side, 0, 0};
+        ValidationResult result = parse_order(side, quantity, price, tick_size, order);
+        append(side, order.quantity, order.price, result);
+    }
+
+    inline void end_line(LineFields& line) {
+        size_t count = line.count;
+        line.count   = 0;
+        if (count == 0) return; // Blank line.
+        if (count != 3) {
+            orders.malformed_lines++;
+            return;
+        }
+
+        string_view side_field    (text.data() + line.starts[0], line.ends[0] - line.starts[0]);
+        string_view quantity_field(text.data() + line.starts[1], line.ends[1] - line.starts[1]);
+        string_view price_field   (text.data() + line.starts[2], line.ends[2] - line.starts[2]);
+
+        // Bitwise rather than short-circuit operators: the side of the next order is a coin flip, a branch
+        // on it would be mispredicted half the time.
+        char side     = side_field[0];
+        bool bad_side = (side_field.size() != 1) | ((side != 'B') & (side != 'S'));
+        if (bad_side) {
+            append(side, 0, 0, ValidationResult::INVALID_SIDE);
+            return;
+        }
+
+        // Quantity: 1 to 8 digits without a leading zero.
+        Quantity quantity;
+        if (quantity_field.size() > 8 || endian::native != endian::little) {
+            append_parsed(side, quantity_field, price_field);
+            return;
+        }
+        if (quantity_field[0] == '0' ||
+            !parse_digits(quantity_field.data(), quantity_field.size(), can_overread(line.starts[1]), quantity)) {
+            append(side, 0, 0, ValidationResult::INVALID_QUANTITY);
+            return;
+        }
+
+        // Price: up to 8 integer and 8 fractional digits.
+        size_t dot          = price_field.find('.');
+        size_t integer_len  = dot == string_view::npos ? price_field.size() : dot;
+        size_t fraction_len = dot == string_view::npos ? 0 : price_field.size() - dot - 1;
+        if (integer_len > 8 || fraction_len > 8) {
+            append_parsed(side, quantity_field, price_field);
+            return;
+        }
+
+        // Fractional digits beyond tick_size.decimals are truncated, but must still be digits.
+        size_t kept_len       = min(fraction_len, static_cast<size_t>(tick_size.decimals));
+        size_t fraction_start = line.starts[2] + integer_len + 1;
+        size_t dropped_start  = fraction_start + kept_len;
+        Price  integer_part, fraction, dropped;
+        bool valid = (dot == string_view::npos || fraction_len > 0) &&
+                     parse_digits(price_field.data(), integer_len, can_overread(line.starts[2]), integer_part) &&
+                     parse_digits(text.data() + fraction_start, kept_len, can_overread(fraction_start), fraction) &&
+                     parse_digits(text.data() + dropped_start, fraction_len - kept_len, can_overread(dropped_start), dropped);
+        if (!valid) {
+            append(side, quantity, 0, ValidationResult::INVALID_PRICE);
+            return;
+        }
+
+        // Side and quantity are already valid, and the price is a multiple of the tick once truncated, so
+        // of validate_order's checks only the minimum price is left.
+        Price price = integer_part * one + fraction * POWERS_OF_10[tick_size.decimals - kept_len];
+        if (tick_size.units != 1) price = tick_size.round_down(price);
+        append(side, quantity, price, price < tick_size.units ? ValidationResult::INVALID_PRICE : ValidationResult::VALID);
+    }
+};
+
+}
+
+size_t tokenize_orders(string_view text, const TickSize& tick_size, OrderColumns& orders) {
+    size_t rows_before = orders.size();
+    orders.reserve(rows_before + text.size() / 10);
+
+    RowParser  parser(text, tick_size, orders);
+    LineFields line;
+    size_t     token_start        = NO_TOKEN;
+    uint64_t   previous_separator = 1; // The start of the buffer acts like a separator.
+
+    auto end_token = [&](size_t end) {
+        if (line.count < 3) {
+            line.starts[line.count] = token_start;
+            line.ends[line.count]   = end;
+        }
+        line.count++;
+        token_start = NO_TOKEN;
+    };
+
+    for (size_t base = 0; base < text.size(); base += BLOCK_SIZE) {
+        BlockMasks masks;
+        if (base + BLOCK_SIZE <= text.size()) {
+            masks = classify(text.data() + base);
+        } else {
+            char padded[BLOCK_SIZE];
+            memset(padded, '\n', BLOCK_SIZE);
+            memcpy(padded, text.data() + base, text.size() - base);
+            masks = classify(padded);
+        }
+
+        // Bits where a token starts or ends, and the newlines (which also end the line).
+        uint64_t separators = masks.separators;
+        uint64_t events     = (separators ^ ((separators << 1) | previous_separator)) | masks.newlines;
+        previous_separator  = separators >> 63;
+
+        while (events != 0) {
+            size_t bit = static_cast<size_t>(countr_zero(events));
+            events    &= events - 1;
+            if (!((separators >> bit) & 1)) {
+                token_start = base + bit;
+                continue;
+            }
+            if (token_start != NO_TOKEN) end_token(base + bit);
+            if ((masks.newlines >> bit) & 1) parser.end_line(line);
+        }
+    }
+
+    // A buffer that is a whole number of blocks may end inside a line.
+    if (token_start != NO_TOKEN) end_token(text.size());
+    parser.end_line(line);
+    return orders.size() - rows_before;
+}
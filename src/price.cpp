@@ -0,0 +1,30 @@
+/*
+* Implementation of price formatting.
+*/
+
+#include "price.hpp"
+#include <charconv>
+#include <string>
+using namespace std;
+
+
+string format_price(Price price, const TickSize& tick_size) {
+    char text[PRICE_CHARS];
+    return string(text, format_price_to(text, price, tick_size));
+}
+
+char* format_price_to(char* out, Price price, const TickSize& tick_size) {
+    Price scale = tick_size.scale();
+    out = to_chars(out, out + PRICE_CHARS, price / scale).ptr;
+
+    Price fraction = price % scale;
+    if (fraction == 0) return out;
+
+    // Emit exactly "decimals" fractional digits, then trim the zeros on the right.
+    *out++ = '.';
+    for (int i = tick_size.decimals - 1; i >= 0; i--, fraction /= 10)
+        out[i] = static_cast<char>('0' + fraction % 10);
+    out += tick_size.decimals;
+    while (out[-1] == '0') out--;
+    return out;
+}
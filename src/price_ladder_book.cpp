@@ -0,0 +1,437 @@
+/*
+* Implementation of PriceLadderBook class
+*
+* Notes:
+* - A level is found by index arithmetic, never by a tree search.
+* - The best bid/ask index only has to be searched for when the best level empties, and then the
+*   bitmap finds the next non-empty level in a handful of word scans.
+* - Matching (on add, against the opposite side, with the same LevelFill<Policy>) and rendering follow OrderBook exactly, so both engines
+*   print identical output.
+*/
+
+#include "price_ladder_book.hpp"
+#include "book_display.hpp"
+#include <iostream>
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include <string>
+using namespace std;
+
+
+template <class Policy>
+BasicPriceLadderBook<Policy>::BasicPriceLadderBook(Price min_price, Price max_price, TickSize tick_size, EventSink* sink)
+    : tick_size(tick_size), printing_sink(tick_size), sink(sink ? sink : &printing_sink),
+      min_price(max(tick_size.round_down(min_price), tick_size.units)),
+      max_price(max(tick_size.round_down(max_price), this->min_price)),
+      buy_levels(level_index(this->max_price) + 1),
+      sell_levels(buy_levels.size()),
+      buy_bitmap(buy_levels.size()),
+      sell_bitmap(buy_levels.size()),
+      buy_volumes(buy_levels.size()),
+      sell_volumes(buy_levels.size()) {}
+
+template <class Policy>
+OrderId BasicPriceLadderBook<Policy>::add_order(char side, string_view quantity_str, string_view price_str, long timestamp) {
+
+    // Validate and convert the text fields in one pass - the price comes out already scaled.
+    ParsedOrder order;
+    ValidationResult validation_result = parse_order(side, quantity_str, price_str, tick_size, order);
+    if (validation_result != ValidationResult::VALID) {
+        sink->on_reject(RejectEvent{validation_result});
+        return INVALID_ORDER_ID;
+    }
+    return add_order(order.side, order.quantity, order.price, timestamp);
+}
+
+template <class Policy>
+OrderId BasicPriceLadderBook<Policy>::add_order(char side, Quantity quantity, Price price, long timestamp, OrderId id,
+                                                OrderType order_type, AccountId account) {
+    id = accept_order(side, quantity, price, timestamp, id, order_type, account,
+                      validate_order(side, quantity, price, tick_size, order_type));
+    if (id != INVALID_ORDER_ID) sink->flush();
+    return id;
+}
+
+template <class Policy>
+size_t BasicPriceLadderBook<Policy>::add_orders(span<const OrderRequest> requests, span<OrderId> ids) {
+    ValidationResult validation[VALIDATION_BATCH];
+    size_t           succeeded = 0;
+
+    for (size_t start = 0; start < requests.size(); start += VALIDATION_BATCH) {
+        span<const OrderRequest> batch = requests.subspan(start, min(VALIDATION_BATCH, requests.size() - start));
+        validate_orders(batch, tick_size, validation);
+
+        for (size_t i = 0; i < batch.size(); i++) {
+            const OrderRequest& request = batch[i];
+            OrderId result = INVALID_ORDER_ID;
+            if (request.type == RequestType::ADD) {
+                result = accept_order(request.side, request.quantity, request.price, request.timestamp,
+                                      request.id, request.order_type, request.account, validation[i]);
+            } else {
+                bool done = request.type == RequestType::CANCEL ? remove_order(request.id)
+                                                                : amend_order(request.id, request.quantity) == ValidationResult::VALID;
+                result    = done ? request.id : INVALID_ORDER_ID;
+            }
+            if (!ids.empty()) ids[start + i] = result;
+            succeeded += result != INVALID_ORDER_ID;
+        }
+    }
+    if (succeeded > 0) sink->flush();
+    return succeeded;
+}
+
+template <class Policy>
+size_t BasicPriceLadderBook<Policy>::add_orders(const OrderColumns& orders, long first_timestamp, span<OrderId> ids) {
+    size_t accepted = 0;
+    for (size_t i = 0; i < orders.size(); i++) {
+        OrderId id = accept_order(orders.sides[i], orders.quantities[i], orders.prices[i],
+                                  first_timestamp + static_cast<long>(i), INVALID_ORDER_ID, OrderType::LIMIT, DEFAULT_ACCOUNT,
+                                  orders.results[i]);
+        if (!ids.empty()) ids[i] = id;
+        accepted += id != INVALID_ORDER_ID;
+    }
+    if (accepted > 0) sink->flush();
+    return accepted;
+}
+
+template <class Policy>
+OrderId BasicPriceLadderBook<Policy>::accept_order(char side, Quantity quantity, Price price, long timestamp, OrderId id,
+                                                   OrderType order_type, AccountId account,
+                                                   ValidationResult validation_result) {
+    ScopedTimer timer(instrumentation.add_latency);
+
+    if (validation_result == ValidationResult::VALID && order_type != OrderType::MARKET && (price < min_price || price > max_price))
+        validation_result = ValidationResult::PRICE_OUT_OF_RANGE;
+    if (validation_result == ValidationResult::VALID && id != INVALID_ORDER_ID && order_index.find(id) != NULL_ORDER)
+        validation_result = ValidationResult::DUPLICATE_ORDER_ID;
+    if (validation_result == ValidationResult::VALID && risk != nullptr)
+        validation_result = risk->check(account, quantity, price, order_type);
+    if (validation_result == ValidationResult::VALID && order_type == OrderType::POST_ONLY && crosses(side, price))
+        validation_result = ValidationResult::WOULD_CROSS;
+    if (validation_result == ValidationResult::VALID && order_type == OrderType::FOK && !can_fill(side, quantity, price))
+        validation_result = ValidationResult::INSUFFICIENT_LIQUIDITY;
+    if (validation_result != ValidationResult::VALID) {
+        sink->on_reject(RejectEvent{validation_result});
+        return INVALID_ORDER_ID;
+    }
+
+    // Ids the book assigns itself always stay above any id chosen by a caller.
+    if (id == INVALID_ORDER_ID) id = next_order_id++;
+    else                        next_order_id = max(next_order_id, id + 1);
+
+    // A market order trades at whatever prices the opposite side offers.
+    Price limit = order_type != OrderType::MARKET ? price
+                : side == 'B'                     ? numeric_limits<Price>::max() : numeric_limits<Price>::min();
+    Quantity remaining = match(id, side, account, quantity, limit);
+    instrumentation.order_matched();
+
+    // Only limit and post-only orders rest; whatever is left of the others is dropped.
+    bool rests = order_type == OrderType::LIMIT || order_type == OrderType::POST_ONLY;
+    if (remaining > 0 && rests) {
+        // Queue the rest at its level, mark the level as non-empty and move the best price if it improved.
+        OrderHandle new_order = order_pool.allocate(id, side, remaining, price, timestamp, next_sequence++, account);
+        if (risk != nullptr) risk->opened(account, remaining);
+        order_index.insert(id, new_order);
+
+        size_t index = level_index(price);
+        PriceLevel& level = side == 'B' ? buy_levels[index] : sell_levels[index];
+        if (level.empty()) instrumentation.level_created(side);
+        level.push_back(order_pool, new_order);
+        if (side == 'B') {
+            buy_bitmap.set(index);
+            if (best_buy_index == LevelBitmap::npos || index > best_buy_index) best_buy_index = index;
+        } else {
+            sell_bitmap.set(index);
+            if (best_sell_index == LevelBitmap::npos || index < best_sell_index) best_sell_index = index;
+        }
+
+        sink->on_add(AddEvent{id, side, price, remaining, order_pool.info(new_order).sequence});
+        level_updated(side, price, level.total_volume);
+    }
+    return id;
+}
+
+template <class Policy>
+OrderId BasicPriceLadderBook<Policy>::submit(const OrderRequest& request) {
+    switch (request.type) {
+        case RequestType::ADD:
+            return add_order(request.side, request.quantity, request.price, request.timestamp, request.id,
+                             request.order_type, request.account);
+        case RequestType::CANCEL:
+            return cancel_order(request.id) ? request.id : INVALID_ORDER_ID;
+        case RequestType::MODIFY:
+            return modify_order(request.id, request.quantity) == ValidationResult::VALID ? request.id : INVALID_ORDER_ID;
+    }
+    return INVALID_ORDER_ID;
+}
+
+template <class Policy>
+bool BasicPriceLadderBook<Policy>::cancel_order(OrderId id) {
+    bool cancelled = remove_order(id);
+    if (cancelled) sink->flush();
+    return cancelled;
+}
+
+template <class Policy>
+bool BasicPriceLadderBook<Policy>::remove_order(OrderId id) {
+    ScopedTimer timer(instrumentation.cancel_latency);
+    OrderHandle handle = order_index.find(id);
+    if (handle == NULL_ORDER) return false;
+
+    const OrderInfo& info = order_pool.info(handle);
+    CancelEvent cancel{id, info.side, info.price, order_pool[handle].quantity, AmendReason::REQUEST};
+    if (risk != nullptr) risk->closed(info.account, cancel.quantity);
+    char   side  = info.side;
+    size_t index = level_index(info.price);
+
+    order_index.erase(id);
+    PriceLevel& level = side == 'B' ? buy_levels[index] : sell_levels[index];
+    level.remove(order_pool, handle);
+
+    sink->on_cancel(cancel);
+    level_updated(side, cancel.price, level.total_volume);
+    if (!level.empty()) return true;
+
+    // The level emptied - drop it from the bitmap and move the best price if it was the best level.
+    if (side == 'B') {
+        buy_bitmap.clear(index);
+        if (index == best_buy_index)
+            best_buy_index = index == 0 ? LevelBitmap::npos : buy_bitmap.find_prev(index - 1);
+    } else {
+        sell_bitmap.clear(index);
+        if (index == best_sell_index) best_sell_index = sell_bitmap.find_next(index + 1);
+    }
+    return true;
+}
+
+template <class Policy>
+ValidationResult BasicPriceLadderBook<Policy>::modify_order(OrderId id, Quantity new_quantity) {
+    ValidationResult result = amend_order(id, new_quantity);
+    if (result == ValidationResult::VALID) sink->flush();
+    return result;
+}
+
+template <class Policy>
+ValidationResult BasicPriceLadderBook<Policy>::amend_order(OrderId id, Quantity new_quantity) {
+    ScopedTimer timer(instrumentation.modify_latency);
+    OrderHandle handle = order_index.find(id);
+    if (handle == NULL_ORDER) return ValidationResult::UNKNOWN_ORDER_ID;
+    if (new_quantity <= 0)    return ValidationResult::INVALID_QUANTITY;
+
+    OrderNode&       order = order_pool[handle];
+    OrderInfo&       info  = order_pool.info(handle);
+    size_t index = level_index(info.price);
+    PriceLevel& level = info.side == 'B' ? buy_levels[index] : sell_levels[index];
+
+    // An increase is held to the account's limits like a new order of new_quantity, and rejected like one.
+    if (risk != nullptr) {
+        if (new_quantity > order.quantity) {
+            ValidationResult result = risk->can_amend(info.account, new_quantity, info.price, new_quantity - order.quantity);
+            if (result != ValidationResult::VALID) {
+                sink->on_reject(RejectEvent{result});
+                return result;
+            }
+        }
+        if (new_quantity < order.quantity) risk->closed(info.account, order.quantity - new_quantity);
+        else                               risk->opened(info.account, new_quantity - order.quantity);
+    }
+
+    if (new_quantity <= order.quantity) {
+        // Reducing quantity keeps the order's place in the queue.
+        level.total_volume -= order.quantity - new_quantity;
+        order.quantity      = new_quantity;
+    } else {
+        // Increasing it sends the order to the back of its level, with a new sequence number.
+        level.unlink(order_pool, handle);
+        order.quantity = new_quantity;
+        info.sequence  = next_sequence++;
+        level.push_back(order_pool, handle);
+    }
+
+    sink->on_modify(ModifyEvent{id, info.side, info.price, order.quantity, info.sequence, AmendReason::REQUEST});
+    level_updated(info.side, info.price, level.total_volume);
+    return ValidationResult::VALID;
+}
+
+template <class Policy>
+Quantity BasicPriceLadderBook<Policy>::match(OrderId id, char side, AccountId account, Quantity quantity, Price price) {
+
+    // Walk the opposite side from its cached best index for as long as the incoming order crosses it.
+    // An emptied level leaves the bitmap, which then yields the next best level.
+    if (side == 'B') {
+        while (quantity > 0 && best_sell_index != LevelBitmap::npos && level_price(best_sell_index) <= price) {
+            PriceLevel& level = sell_levels[best_sell_index];
+            quantity = LevelFill<Policy>::fill(*this, level, level_price(best_sell_index), id, side, account, quantity);
+            if (!level.empty()) break;
+
+            sell_bitmap.clear(best_sell_index);
+            best_sell_index = sell_bitmap.find_next(best_sell_index + 1);
+        }
+    } else {
+        while (quantity > 0 && best_buy_index != LevelBitmap::npos && level_price(best_buy_index) >= price) {
+            PriceLevel& level = buy_levels[best_buy_index];
+            quantity = LevelFill<Policy>::fill(*this, level, level_price(best_buy_index), id, side, account, quantity);
+            if (!level.empty()) break;
+
+            buy_bitmap.clear(best_buy_index);
+            best_buy_index = best_buy_index == 0 ? LevelBitmap::npos : buy_bitmap.find_prev(best_buy_index - 1);
+        }
+    }
+    return quantity;
+}
+
+template <class Policy>
+bool BasicPriceLadderBook<Policy>::crosses(char side, Price price) const {
+    return side == 'B' ? best_sell_index != LevelBitmap::npos && level_price(best_sell_index) <= price
+                       : best_buy_index  != LevelBitmap::npos && level_price(best_buy_index)  >= price;
+}
+
+template <class Policy>
+bool BasicPriceLadderBook<Policy>::can_fill(char side, Quantity quantity, Price price) {
+    // A buy can take the sells at levels 0..index of its price, a sell the buys at index.. onwards.
+    if (side == 'B') {
+        if (price < min_price) return false;
+        return sell_volumes.prefix(level_index(min(price, max_price))) >= quantity;
+    }
+    if (price > max_price) return false;
+    size_t index = level_index(max(price, min_price));
+    return buy_volumes.total() - (index == 0 ? 0 : buy_volumes.prefix(index - 1)) >= quantity;
+}
+
+template <class Policy>
+void BasicPriceLadderBook<Policy>::print_order_book(size_t max_levels) {
+    renderer.begin();
+
+    // Walk the non-empty levels outwards from the best bid and the best ask.
+    size_t itB = best_buy_index, itS = best_sell_index;
+
+    for (size_t row = 0; row < max_levels && (itB != LevelBitmap::npos || itS != LevelBitmap::npos); row++) {
+        DepthLevel bid, ask;
+        const DepthLevel* bid_cell = nullptr;
+        const DepthLevel* ask_cell = nullptr;
+
+        // Buy levels are visited downwards, sell levels upwards.
+        if (itB != LevelBitmap::npos) {
+            bid      = DepthLevel{level_price(itB), buy_levels[itB].total_volume};
+            bid_cell = &bid;
+            itB      = itB == 0 ? LevelBitmap::npos : buy_bitmap.find_prev(itB - 1);
+        }
+        if (itS != LevelBitmap::npos) {
+            ask      = DepthLevel{level_price(itS), sell_levels[itS].total_volume};
+            ask_cell = &ask;
+            itS      = sell_bitmap.find_next(itS + 1);
+        }
+        renderer.add_row(bid_cell, ask_cell, tick_size);
+    }
+    renderer.write(cout);
+}
+
+template <class Policy>
+TopOfBook BasicPriceLadderBook<Policy>::top_of_book() const {
+    TopOfBook top{};
+    if (best_buy_index != LevelBitmap::npos)
+        top.bid = DepthLevel{level_price(best_buy_index), buy_levels[best_buy_index].total_volume};
+    if (best_sell_index != LevelBitmap::npos)
+        top.ask = DepthLevel{level_price(best_sell_index), sell_levels[best_sell_index].total_volume};
+    return top;
+}
+
+template <class Policy>
+DepthSnapshot BasicPriceLadderBook<Policy>::depth(size_t levels) {
+
+    // Refill a side whose top N lost a level, walking the bitmap outwards from the best level.
+    if (depth_cache.bids.dirty) {
+        depth_cache.bids.reset();
+        for (size_t i = best_buy_index; i != LevelBitmap::npos && !depth_cache.bids.full();
+             i = i == 0 ? LevelBitmap::npos : buy_bitmap.find_prev(i - 1))
+            depth_cache.bids.push_back(level_price(i), buy_levels[i].total_volume);
+    }
+    if (depth_cache.asks.dirty) {
+        depth_cache.asks.reset();
+        for (size_t i = best_sell_index; i != LevelBitmap::npos && !depth_cache.asks.full(); i = sell_bitmap.find_next(i + 1))
+            depth_cache.asks.push_back(level_price(i), sell_levels[i].total_volume);
+    }
+
+    DepthSnapshot snapshot{};
+    levels = min(levels, MAX_DEPTH);
+    snapshot.bid_levels = static_cast<uint32_t>(min<size_t>(levels, depth_cache.bids.count));
+    snapshot.ask_levels = static_cast<uint32_t>(min<size_t>(levels, depth_cache.asks.count));
+    copy_n(depth_cache.bids.levels, snapshot.bid_levels, snapshot.bids);
+    copy_n(depth_cache.asks.levels, snapshot.ask_levels, snapshot.asks);
+    return snapshot;
+}
+
+template <class Policy>
+void BasicPriceLadderBook<Policy>::export_orders(vector<OrderRecord>& orders) const {
+    orders.reserve(orders.size() + order_index.size());
+    for (const auto* side : {&buy_bitmap, &sell_bitmap}) {
+        const vector<PriceLevel>& levels = side == &buy_bitmap ? buy_levels : sell_levels;
+        for (size_t index = side->find_first(); index != LevelBitmap::npos; index = side->find_next(index + 1)) {
+            for (OrderHandle handle = levels[index].head; handle != NULL_ORDER; handle = order_pool[handle].next) {
+                const OrderInfo& info = order_pool.info(handle);
+                orders.push_back(OrderRecord{order_pool[handle].id, order_pool[handle].quantity, info.price, info.timestamp,
+                                             info.side, {}, info.account});
+            }
+        }
+    }
+}
+
+template <class Policy>
+bool BasicPriceLadderBook<Policy>::restore(span<const OrderRecord> orders, OrderId next_order_id) {
+    if (best_buy_index != LevelBitmap::npos || best_sell_index != LevelBitmap::npos) return false;
+    for (const OrderRecord& record : orders)
+        if (record.id == INVALID_ORDER_ID || record.price < min_price || record.price > max_price ||
+            validate_order(record.side, record.quantity, record.price, tick_size) != ValidationResult::VALID ||
+            (risk != nullptr && record.account >= risk->accounts())) return false;
+
+    OrderId max_id = INVALID_ORDER_ID;
+    for (size_t i = 0; i < orders.size(); i++) {
+        const OrderRecord& record = orders[i];
+        if (order_index.find(record.id) != NULL_ORDER) {
+            // Undo the orders loaded so far.
+            for (size_t j = 0; j < i; j++) {
+                size_t index = level_index(orders[j].price);
+                order_pool.release(order_index.find(orders[j].id));
+                order_index.erase(orders[j].id);
+                if (orders[j].side == 'B') { buy_levels[index]  = PriceLevel{}; buy_bitmap.clear(index);  }
+                else                       { sell_levels[index] = PriceLevel{}; sell_bitmap.clear(index); }
+            }
+            return false;
+        }
+
+        size_t      index  = level_index(record.price);
+        PriceLevel& level  = record.side == 'B' ? buy_levels[index] : sell_levels[index];
+        OrderHandle handle = order_pool.allocate(record.id, record.side, record.quantity, record.price, record.timestamp,
+                                                 next_sequence++, record.account);
+        if (level.empty()) instrumentation.level_created(record.side);
+        level.push_back(order_pool, handle);
+        (record.side == 'B' ? buy_bitmap : sell_bitmap).set(index);
+        order_index.insert(record.id, handle);
+        max_id = max(max_id, record.id);
+    }
+
+    // The best levels and the level volume sums are brought up to date once, after the whole load.
+    for (const OrderRecord& record : orders) {
+        size_t index = level_index(record.price);
+        if (record.side == 'B') buy_volumes.set(index, buy_levels[index].total_volume);
+        else                    sell_volumes.set(index, sell_levels[index].total_volume);
+    }
+    best_buy_index  = buy_bitmap.find_last();
+    best_sell_index = sell_bitmap.find_first();
+    if (risk != nullptr)
+        for (const OrderRecord& record : orders) risk->opened(record.account, record.quantity);
+    this->next_order_id = max(next_order_id, max_id + 1);
+    depth_cache.bids.dirty = depth_cache.asks.dirty = true;
+    return true;
+}
+
+// The match policies the library is built with; other policies need their own instantiation here.
+template class BasicPriceLadderBook<PriceTimePolicy>;
+template class BasicPriceLadderBook<MatchPolicy<SelfTradePrevention::CANCEL_NEWEST>>;
+template class BasicPriceLadderBook<MatchPolicy<SelfTradePrevention::CANCEL_OLDEST>>;
+template class BasicPriceLadderBook<MatchPolicy<SelfTradePrevention::DECREMENT>>;
+template class BasicPriceLadderBook<MatchPolicy<SelfTradePrevention::NONE, ProRataAllocation>>;
+template class BasicPriceLadderBook<MatchPolicy<SelfTradePrevention::CANCEL_NEWEST, ProRataAllocation>>;
+template class BasicPriceLadderBook<MatchPolicy<SelfTradePrevention::CANCEL_OLDEST, ProRataAllocation>>;
+template class BasicPriceLadderBook<MatchPolicy<SelfTradePrevention::DECREMENT, ProRataAllocation>>;
@@ -0,0 +1,69 @@
+/*
+* Implementation of Sequencer
+*/
+
+#include "sequencer.hpp"
+#include <thread>
+using namespace std;
+
+
+Sequencer::Sequencer(StockOrderBook& stocks, size_t producer_count, size_t queue_capacity) : stocks(stocks) {
+    if (producer_count == 0) producer_count = 1;
+    producers.reserve(producer_count);
+    for (size_t i = 0; i < producer_count; i++) producers.push_back(make_unique<Producer>(queue_capacity));
+}
+
+Sequencer::~Sequencer() {
+    stop();
+}
+
+void Sequencer::start() {
+    if (running.exchange(true)) return;
+    worker = thread(&Sequencer::run, this);
+}
+
+void Sequencer::stop() {
+    if (!running.exchange(false)) return;
+    if (worker.joinable()) worker.join();
+}
+
+size_t Sequencer::drain(Producer& producer) {
+    uint64_t       sequence = next_sequence.load(memory_order_relaxed);
+    GatewayRequest next;
+    size_t         count = 0;
+    while (count < SEQUENCER_BATCH && producer.queue.try_pop(next)) {
+        if (stocks.submit(next.symbol, next.request, sequence)) sequence++;
+        count++;
+    }
+    if (count > 0) {
+        next_sequence.store(sequence, memory_order_release);
+        taken.store(taken.load(memory_order_relaxed) + count, memory_order_release);
+    }
+    return count;
+}
+
+void Sequencer::run() {
+    while (true) {
+        size_t count = 0;
+        for (auto& producer : producers) count += drain(*producer);
+        if (count > 0) continue;
+
+        if (running.load(memory_order_acquire)) {
+            this_thread::yield();
+        } else {
+            // Stopped: finish once a pass over the rings found them all empty.
+            bool empty = true;
+            for (auto& producer : producers) empty = empty && producer->queue.empty();
+            if (empty) return;
+        }
+    }
+}
+
+void Sequencer::wait_idle() const {
+    uint64_t submitted = 0;
+    for (const auto& producer : producers) submitted += producer->submitted.load(memory_order_acquire);
+    while (taken.load(memory_order_acquire) < submitted) this_thread::yield();
+
+    // Everything taken has been handed to the shards; wait for them to process it.
+    stocks.wait_idle();
+}
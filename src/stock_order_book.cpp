@@ -0,0 +1,114 @@
+/*
+* Implementation of SymbolRegistry and StockOrderBook
+*/
+
+#include "stock_order_book.hpp"
+#include <thread>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+using namespace std;
+
+
+SymbolId SymbolRegistry::intern(string_view name) {
+    auto it = ids.find(name);
+    if (it != ids.end()) return it->second;
+
+    SymbolId id = static_cast<SymbolId>(names.size());
+    names.emplace_back(name);
+    ids.emplace(names.back(), id);
+    return id;
+}
+
+SymbolId SymbolRegistry::find(string_view name) const {
+    auto it = ids.find(name);
+    return it == ids.end() ? INVALID_SYMBOL_ID : it->second;
+}
+
+StockOrderBook::StockOrderBook(size_t shard_count, TickSize tick_size, function<EventSink*(SymbolId)> sink_for_symbol,
+                               bool pin_threads, size_t queue_capacity)
+    : tick_size(tick_size), sink_for_symbol(move(sink_for_symbol)), pin_threads(pin_threads) {
+    if (shard_count == 0) shard_count = 1;
+    shards.reserve(shard_count);
+    for (size_t i = 0; i < shard_count; i++) shards.push_back(make_unique<Shard>(queue_capacity));
+}
+
+StockOrderBook::~StockOrderBook() {
+    stop();
+}
+
+SymbolId StockOrderBook::add_symbol(string_view name) {
+    SymbolId existing = symbols.find(name);
+    if (existing != INVALID_SYMBOL_ID || running.load(memory_order_relaxed)) return existing;
+
+    SymbolId   id   = symbols.intern(name);
+    EventSink* sink = sink_for_symbol ? sink_for_symbol(id) : nullptr;
+    if (sink == nullptr) sink = &null_sink;
+    shards[id % shards.size()]->books.push_back(make_unique<OrderBook>(tick_size, sink));
+    return id;
+}
+
+void StockOrderBook::start() {
+    if (running.exchange(true)) return;
+    for (size_t i = 0; i < shards.size(); i++) shards[i]->worker = thread(&StockOrderBook::run_shard, this, i);
+}
+
+void StockOrderBook::stop() {
+    if (!running.exchange(false)) return;
+    for (auto& shard : shards)
+        if (shard->worker.joinable()) shard->worker.join();
+}
+
+void StockOrderBook::run_shard(size_t shard_index) {
+#ifdef __linux__
+    if (pin_threads) {
+        unsigned cpus = thread::hardware_concurrency();
+        if (cpus > 0) {
+            cpu_set_t cpu_set;
+            CPU_ZERO(&cpu_set);
+            CPU_SET(shard_index % cpus, &cpu_set);
+            pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set);
+        }
+    }
+#endif
+
+    Shard&       shard = *shards[shard_index];
+    ShardRequest next;
+    while (true) {
+        if (shard.queue.try_pop(next)) {
+            shard.books[next.book]->submit(next.request);
+            if (next.sequence != 0) shard.last_sequence.store(next.sequence, memory_order_release);
+            shard.processed.store(shard.processed.load(memory_order_relaxed) + 1, memory_order_release);
+        } else if (running.load(memory_order_acquire)) {
+            this_thread::yield();
+        } else if (shard.queue.empty()) {
+            // Stopped, and everything queued before stop() has been processed.
+            return;
+        }
+    }
+}
+
+bool StockOrderBook::submit(SymbolId symbol, const OrderRequest& request, uint64_t sequence) {
+    if (symbol >= symbols.size()) return false;
+
+    Shard&       shard = *shards[symbol % shards.size()];
+    ShardRequest entry{static_cast<uint32_t>(symbol / shards.size()), sequence, request};
+    while (!shard.queue.try_push(entry)) this_thread::yield();
+    shard.submitted.store(shard.submitted.load(memory_order_relaxed) + 1, memory_order_release);
+    return true;
+}
+
+void StockOrderBook::wait_idle() const {
+    for (const auto& shard : shards)
+        while (shard->processed.load(memory_order_acquire) != shard->submitted.load(memory_order_acquire))
+            this_thread::yield();
+}
+
+OrderBook& StockOrderBook::book(SymbolId symbol) {
+    return *shards[symbol % shards.size()]->books[symbol / shards.size()];
+}
+
+const OrderBook& StockOrderBook::book(SymbolId symbol) const {
+    return *shards[symbol % shards.size()]->books[symbol / shards.size()];
+}
@@ -0,0 +1,34 @@
+/*
+* Implementation of TscClock
+*/
+
+#include "tsc_clock.hpp"
+#include <chrono>
+using namespace std;
+
+
+static int64_t steady_ns() {
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static int64_t system_ns() {
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::system_clock::now().time_since_epoch()).count();
+}
+
+TscClock::TscClock(chrono::nanoseconds calibration) {
+    first_steady_ns = steady_ns();
+    first_ticks     = ticks();
+
+    // Busy-wait rather than sleep, so the measured interval is not stretched by a late wakeup.
+    while (steady_ns() - first_steady_ns < calibration.count()) {}
+    resync(ticks());
+}
+
+void TscClock::resync(uint64_t now_ticks) {
+    // The rate is measured over the whole life of the clock, so it gets more accurate with every resync.
+    int64_t elapsed_ns = steady_ns() - first_steady_ns;
+    ns_per_tick  = now_ticks > first_ticks ? static_cast<double>(elapsed_ns) / static_cast<double>(now_ticks - first_ticks) : 1.0;
+    base_ticks   = now_ticks;
+    base_ns      = system_ns();
+    resync_ticks = now_ticks + static_cast<uint64_t>(static_cast<double>(RESYNC_NS) / ns_per_tick);
+}
@@ -0,0 +1,98 @@
+/*
+* Implementation of the what-if replay
+*/
+
+#include "what_if.hpp"
+#include "book_snapshot.hpp"
+#include "event_sink.hpp"
+#include "order_book.hpp"
+#include <algorithm>
+#include <atomic>
+#include <thread>
+using namespace std;
+
+
+bool load_what_if_start(const string& path, WhatIfStart& start) {
+    MappedSnapshot file;
+    if (!file.open(path) || file.header() == nullptr) return false;
+
+    const SnapshotHeader& header = *file.header();
+    span<const OrderRecord> orders = file.orders();
+    start.tick_size        = TickSize{header.tick_decimals, header.tick_units};
+    start.next_order_id    = header.next_order_id;
+    start.journal_sequence = header.journal_sequence;
+    start.orders.assign(orders.begin(), orders.end());
+    return true;
+}
+
+// Run one variant in a book of Policy. journal holds only the records after the start.
+template <class Policy>
+WhatIfResult run_variant(const WhatIfStart& start, span<const JournalRecord> journal, const WhatIfVariant& variant) {
+    TickSize tick_size = start.tick_size;
+    if (variant.tick_units != 0) tick_size.units = variant.tick_units;
+
+    WhatIfResult result;
+    ChecksumSink sink;
+    BasicOrderBook<Policy> order_book(tick_size, &sink);
+    if (!tick_size.is_valid() || !order_book.restore(start.orders, start.next_order_id)) return result;
+    result.started = true;
+
+    auto injected = variant.injected.begin();
+    for (const JournalRecord& record : journal) {
+        for (; injected != variant.injected.end() && injected->after_sequence < record.sequence; ++injected) {
+            order_book.submit(injected->request);
+            result.requests++;
+        }
+        order_book.submit(record.request());
+        result.requests++;
+    }
+    for (; injected != variant.injected.end(); ++injected) {
+        order_book.submit(injected->request);
+        result.requests++;
+    }
+
+    result.checksum      = sink.checksum();
+    result.trades        = sink.trades();
+    result.traded_volume = sink.traded_volume();
+    result.rejects       = sink.rejects();
+    result.top           = order_book.top_of_book();
+    return result;
+}
+
+// Pick the book of the variant's policy, one of those the library is built with.
+template <SelfTradePrevention SELF_TRADE>
+WhatIfResult run_variant(const WhatIfStart& start, span<const JournalRecord> journal, const WhatIfVariant& variant) {
+    if (variant.pro_rata) return run_variant<MatchPolicy<SELF_TRADE, ProRataAllocation>>(start, journal, variant);
+    return run_variant<MatchPolicy<SELF_TRADE>>(start, journal, variant);
+}
+
+WhatIfResult run_variant(const WhatIfStart& start, span<const JournalRecord> journal, const WhatIfVariant& variant) {
+    switch (variant.self_trade) {
+        case SelfTradePrevention::CANCEL_NEWEST: return run_variant<SelfTradePrevention::CANCEL_NEWEST>(start, journal, variant);
+        case SelfTradePrevention::CANCEL_OLDEST: return run_variant<SelfTradePrevention::CANCEL_OLDEST>(start, journal, variant);
+        case SelfTradePrevention::DECREMENT:     return run_variant<SelfTradePrevention::DECREMENT>(start, journal, variant);
+        default:                                 return run_variant<SelfTradePrevention::NONE>(start, journal, variant);
+    }
+}
+
+vector<WhatIfResult> run_what_if(const WhatIfStart& start, span<const JournalRecord> journal,
+                                 span<const WhatIfVariant> variants, size_t threads) {
+    auto first = partition_point(journal.begin(), journal.end(),
+                                 [&](const JournalRecord& record) { return record.sequence <= start.journal_sequence; });
+    journal = journal.subspan(static_cast<size_t>(first - journal.begin()));
+
+    // Each thread takes the next variant not yet taken and writes its result in the variant's slot.
+    vector<WhatIfResult> results(variants.size());
+    atomic<size_t>       next_variant{0};
+    auto work = [&] {
+        for (size_t i; (i = next_variant.fetch_add(1, memory_order_relaxed)) < variants.size();)
+            results[i] = run_variant(start, journal, variants[i]);
+    };
+
+    threads = clamp<size_t>(threads, 1, max<size_t>(variants.size(), 1));
+    vector<thread> pool;
+    for (size_t i = 1; i < threads; i++) pool.emplace_back(work);
+    work();
+    for (thread& worker : pool) worker.join();
+    return results;
+}